@@ -1,38 +1,142 @@
 #include "Bus.hpp"
 #include "Color.hpp"
 #include "CPU.hpp"
+#include "Devices.hpp"
+#include "FrameScheduler.hpp"
+#include "Movie.hpp"
+#include "Programs.hpp"
 #include "Renderer.hpp"
+#include "RewindBuffer.hpp"
+#include "SpscQueue.hpp"
+#include "TripleBuffer.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <memory>
-#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 #include <Windows.h>
 
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
-bool read_screen_state(CPU& cpu, std::vector<uint8_t>& frame) {
-    bool update = false;
-    size_t frame_idx = 0;
+// Vitesse historique : 60 cycles par trame  60 Hz
+#define DEFAULT_CLOCK_HZ 3600
+#define DEFAULT_FRAME_RATE 60
+#define INPUT_QUEUE_SIZE 64
+// Un quart d'heure d'historique ou plus  60 trames par seconde avec les programmes fournis
+#define REWIND_BUDGET (8 << 20)
 
-    for (uint16_t i = 0x0200; i < 0x0600; ++i) {
-        uint8_t color_idx = cpu.mem_read(i);
-        Color col = color(color_idx);
-        uint8_t r = col.r;
-        uint8_t g = col.g;
-        uint8_t b = col.b;
+using FramePixels = std::array<uint8_t, FRAMEBUFFER_SIZE>;
+using InputQueue = SpscQueue<uint8_t, INPUT_QUEUE_SIZE>;
 
-        if (frame[frame_idx] != r || frame[frame_idx + 1] != g || frame[frame_idx + 2] != b) {
-            frame[frame_idx] = r;
-            frame[frame_idx + 1] = g;
-            frame[frame_idx + 2] = b;
-            update = true;
+// Du thread de la fentre vers celui de l'mulation : touches pour $FF et retour arrire maintenu
+struct HostInput {
+    InputQueue keys;
+    std::atomic<bool> rewind_held{ false };
+};
+
+struct Options {
+    uint32_t clock_hz = DEFAULT_CLOCK_HZ;
+    uint32_t frame_rate = DEFAULT_FRAME_RATE;
+    double speed = 1.0;
+    bool turbo = false;
+    uint32_t seed = static_cast<uint32_t>(time(nullptr));
+    std::string record;
+};
+
+// --clock HZ, --frame-rate N, --speed X, --turbo, --seed N, --record <film>
+Options parse_command_line(const char* command_line) {
+    Options options;
+    std::istringstream args(command_line ? command_line : "");
+    std::string arg;
+
+    while (args >> arg) {
+        if (arg == "--turbo") {
+            options.turbo = true;
+        }
+        else if (arg == "--clock") {
+            args >> options.clock_hz;
+        }
+        else if (arg == "--frame-rate") {
+            args >> options.frame_rate;
+        }
+        else if (arg == "--speed") {
+            args >> options.speed;
         }
-        frame_idx += 3;
+        else if (arg == "--seed") {
+            args >> options.seed;
+        }
+        else if (arg == "--record") {
+            args >> options.record;
+        }
+        else {
+            std::cerr << "Option inconnue : " << arg << std::endl;
+        }
+    }
+    return options;
+}
+
+// Thread d'mulation : applique les touches reues, excute une trame puis publie l'cran s'il a chang.
+// Il se cale sur l'horloge mule du scheduler, indpendamment de la prsentation.
+// Les touches sont aussi consignes dans movie, au cycle o le CPU les voit, pour tre rejoues par Headless.
+// Tant que le retour arrire est maintenu, chaque trame restaure la prcdente au lieu d'excuter le CPU.
+void emulation_loop(CPU& cpu, Bus& bus, FrameScheduler& scheduler, KeyboardLatch& keyboard, Framebuffer& framebuffer, HostInput& input, TripleBuffer<FramePixels>& frames, Movie& movie, RewindBuffer* rewind, std::atomic<bool>& running) {
+    while (running.load(std::memory_order_relaxed)) {
+        uint8_t key;
+        while (input.keys.pop(key)) {
+            keyboard.press(key);
+            movie.record_key(scheduler.total_cycles(), key);
+        }
+
+        if (rewind && input.rewind_held.load(std::memory_order_relaxed)) {
+            rewind->rewind(cpu, bus, rewind->size() > 1 ? 1 : 0);
+            framebuffer.invalidate();
+        }
+        else {
+            if (rewind) {
+                rewind->push(cpu, bus);
+            }
+            scheduler.run_frame(cpu);
+        }
+
+        if (framebuffer.take_dirty_rows() != 0) {
+            framebuffer.copy_pixels(frames.back().data());
+            frames.publish();
+        }
+
+        if (!cpu.is_cpu_running()) {
+            const StopInfo& stop = cpu.stop_info();
+            if (stop.reason == StopReason::IllegalOpcode) {
+                std::fprintf(stderr, "Opcode non document $%02X en $%04X\n", bus.peek(stop.address), stop.address);
+            }
+            running.store(false, std::memory_order_relaxed);
+            break;
+        }
+
+        scheduler.wait_next_frame();
     }
-    return update;
+}
+
+// Convertit en RGBA les seules lignes qui diffrent de la trame affiche prcdemment et les renvoie
+uint32_t read_screen_state(const FramePixels& pixels, FramePixels& shown, std::vector<uint8_t>& frame) {
+    uint32_t dirty_rows = 0;
+
+    for (int y = 0; y < FRAMEBUFFER_HEIGHT; ++y) {
+        size_t offset = static_cast<size_t>(y) * FRAMEBUFFER_WIDTH;
+        if (std::memcmp(&pixels[offset], &shown[offset], FRAMEBUFFER_WIDTH) != 0) {
+            std::memcpy(&shown[offset], &pixels[offset], FRAMEBUFFER_WIDTH);
+            expand_palette(&pixels[offset], FRAMEBUFFER_WIDTH, 1, &frame[offset * 4], FRAMEBUFFER_WIDTH * 4);
+            dirty_rows |= 1u << y;
+        }
+    }
+    return dirty_rows;
 }
 
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
@@ -55,6 +159,19 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     auto bus = std::make_unique<Bus>();
     auto cpu = std::make_unique<CPU>(*bus);
 
+    Options options = parse_command_line(lpCmdLine);
+    auto random_device = std::make_unique<RandomDevice>(options.seed);
+    auto keyboard = std::make_unique<KeyboardLatch>();
+    auto framebuffer = std::make_unique<Framebuffer>();
+    auto input = std::make_unique<HostInput>();
+    auto scheduler = std::make_unique<FrameScheduler>(options.clock_hz, options.frame_rate);
+    scheduler->set_speed(options.speed);
+    scheduler->set_turbo(options.turbo);
+    auto frames = std::make_unique<TripleBuffer<FramePixels>>();
+    random_device->attach(*bus);
+    keyboard->attach(*bus);
+    framebuffer->attach(*bus);
+
     hwnd = CreateWindowEx(
         0,
         CLASS_NAME,
@@ -65,7 +182,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         NULL,
         NULL,
         hInstance,
-        cpu.get()
+        input.get()
     );
 
     if (hwnd == NULL)
@@ -84,67 +201,38 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         return -1;
     }
 
-    auto running = std::make_unique<bool>(true);
-    /* https://skilldrick.github.io/easy6502/#snake */
-    auto game_code = std::make_unique<std::vector<uint8_t>>(std::initializer_list<uint8_t>{
-        0x20, 0x06, 0x06, 0x20, 0x38, 0x06, 0x20, 0x0d, 0x06, 0x20, 0x2a, 0x06, 0x60, 0xa9, 0x02,
-            0x85, 0x02, 0xa9, 0x04, 0x85, 0x03, 0xa9, 0x11, 0x85, 0x10, 0xa9, 0x10, 0x85, 0x12, 0xa9,
-            0x0f, 0x85, 0x14, 0xa9, 0x04, 0x85, 0x11, 0x85, 0x13, 0x85, 0x15, 0x60, 0xa5, 0xfe, 0x85,
-            0x00, 0xa5, 0xfe, 0x29, 0x03, 0x18, 0x69, 0x02, 0x85, 0x01, 0x60, 0x20, 0x4d, 0x06, 0x20,
-            0x8d, 0x06, 0x20, 0xc3, 0x06, 0x20, 0x19, 0x07, 0x20, 0x20, 0x07, 0x20, 0x2d, 0x07, 0x4c,
-            0x38, 0x06, 0xa5, 0xff, 0xc9, 0x77, 0xf0, 0x0d, 0xc9, 0x64, 0xf0, 0x14, 0xc9, 0x73, 0xf0,
-            0x1b, 0xc9, 0x61, 0xf0, 0x22, 0x60, 0xa9, 0x04, 0x24, 0x02, 0xd0, 0x26, 0xa9, 0x01, 0x85,
-            0x02, 0x60, 0xa9, 0x08, 0x24, 0x02, 0xd0, 0x1b, 0xa9, 0x02, 0x85, 0x02, 0x60, 0xa9, 0x01,
-            0x24, 0x02, 0xd0, 0x10, 0xa9, 0x04, 0x85, 0x02, 0x60, 0xa9, 0x02, 0x24, 0x02, 0xd0, 0x05,
-            0xa9, 0x08, 0x85, 0x02, 0x60, 0x60, 0x20, 0x94, 0x06, 0x20, 0xa8, 0x06, 0x60, 0xa5, 0x00,
-            0xc5, 0x10, 0xd0, 0x0d, 0xa5, 0x01, 0xc5, 0x11, 0xd0, 0x07, 0xe6, 0x03, 0xe6, 0x03, 0x20,
-            0x2a, 0x06, 0x60, 0xa2, 0x02, 0xb5, 0x10, 0xc5, 0x10, 0xd0, 0x06, 0xb5, 0x11, 0xc5, 0x11,
-            0xf0, 0x09, 0xe8, 0xe8, 0xe4, 0x03, 0xf0, 0x06, 0x4c, 0xaa, 0x06, 0x4c, 0x35, 0x07, 0x60,
-            0xa6, 0x03, 0xca, 0x8a, 0xb5, 0x10, 0x95, 0x12, 0xca, 0x10, 0xf9, 0xa5, 0x02, 0x4a, 0xb0,
-            0x09, 0x4a, 0xb0, 0x19, 0x4a, 0xb0, 0x1f, 0x4a, 0xb0, 0x2f, 0xa5, 0x10, 0x38, 0xe9, 0x20,
-            0x85, 0x10, 0x90, 0x01, 0x60, 0xc6, 0x11, 0xa9, 0x01, 0xc5, 0x11, 0xf0, 0x28, 0x60, 0xe6,
-            0x10, 0xa9, 0x1f, 0x24, 0x10, 0xf0, 0x1f, 0x60, 0xa5, 0x10, 0x18, 0x69, 0x20, 0x85, 0x10,
-            0xb0, 0x01, 0x60, 0xe6, 0x11, 0xa9, 0x06, 0xc5, 0x11, 0xf0, 0x0c, 0x60, 0xc6, 0x10, 0xa5,
-            0x10, 0x29, 0x1f, 0xc9, 0x1f, 0xf0, 0x01, 0x60, 0x4c, 0x35, 0x07, 0xa0, 0x00, 0xa5, 0xfe,
-            0x91, 0x00, 0x60, 0xa6, 0x03, 0xa9, 0x00, 0x81, 0x10, 0xa2, 0x00, 0xa9, 0x01, 0x81, 0x10,
-            0x60, 0xa6, 0xff, 0xea, 0xea, 0xca, 0xd0, 0xfb, 0x60
-    });
-
-    /* https://skilldrick.github.io/easy6502/simulator.html 
-    auto game_code = std::make_unique<std::vector<uint8_t>>(std::initializer_list<uint8_t>{
-        0x20, 0x54, 0x06, 0x20, 0x70, 0x06, 0x20, 0xc9, 0x06, 0x4c, 0x03, 0x06, 0x60, 0x48, 0x8a, 0x48,
-            0xa9, 0x00, 0xa6, 0x10, 0x9d, 0x00, 0x05, 0xa6, 0x78, 0xa9, 0x01, 0x9d, 0x00, 0x05, 0x86, 0x10,
-            0xa9, 0x00, 0xa6, 0x11, 0x9d, 0x00, 0x05, 0xa6, 0x79, 0xa9, 0x03, 0x9d, 0x00, 0x05, 0x86, 0x11,
-            0xa9, 0x00, 0xa6, 0x12, 0x9d, 0x00, 0x05, 0xa6, 0x7a, 0xa9, 0x04, 0x9d, 0x00, 0x05, 0x86, 0x12,
-            0xa9, 0x00, 0xa6, 0x13, 0x9d, 0x00, 0x05, 0xa6, 0x7b, 0xa9, 0x04, 0x9d, 0x00, 0x05, 0x86, 0x13,
-            0x68, 0xaa, 0x68, 0x60, 0xa2, 0x00, 0xad, 0x0a, 0x07, 0x9d, 0x00, 0x02, 0x9d, 0x00, 0x04, 0xca,
-            0xe0, 0x00, 0xd0, 0xf5, 0xa9, 0x10, 0x85, 0x80, 0xa2, 0x0f, 0x95, 0x81, 0xca, 0x10, 0xfb, 0x60,
-            0xa9, 0x00, 0x85, 0x78, 0xa9, 0x20, 0x85, 0x79, 0xa9, 0xc0, 0x85, 0x7a, 0xa9, 0xe0, 0x85, 0x7b,
-            0xa2, 0x0f, 0xb5, 0x81, 0x95, 0x82, 0xa8, 0x84, 0x02, 0xb9, 0xea, 0x06, 0x85, 0x00, 0xc8, 0xb9,
-            0xea, 0x06, 0x85, 0x01, 0xad, 0x0a, 0x07, 0xa4, 0x78, 0x91, 0x00, 0xc8, 0x91, 0x00, 0xa4, 0x7b,
-            0x91, 0x00, 0xc8, 0x91, 0x00, 0xa4, 0x79, 0xa9, 0x00, 0x91, 0x00, 0xc8, 0x91, 0x00, 0xa4, 0x7a,
-            0x91, 0x00, 0xc8, 0x91, 0x00, 0xe6, 0x78, 0xe6, 0x79, 0xe6, 0x7a, 0xe6, 0x7b, 0xe6, 0x78, 0xe6,
-            0x79, 0xe6, 0x7a, 0xe6, 0x7b, 0xca, 0x10, 0xba, 0x60, 0xa5, 0x80, 0xc5, 0x81, 0xf0, 0x09, 0xa5,
-            0x80, 0x18, 0xe5, 0x81, 0x10, 0x0f, 0x30, 0x08, 0xa5, 0xfe, 0x29, 0x0f, 0x0a, 0x85, 0x80, 0x60,
-            0xc6, 0x81, 0xc6, 0x81, 0x60, 0xe6, 0x81, 0xe6, 0x81, 0x60, 0x00, 0x02, 0x20, 0x02, 0x40, 0x02,
-            0x60, 0x02, 0x80, 0x02, 0xa0, 0x02, 0xc0, 0x02, 0xe0, 0x02, 0x00, 0x03, 0x20, 0x03, 0x40, 0x03,
-            0x60, 0x03, 0x80, 0x03, 0xa0, 0x03, 0xc0, 0x03, 0xe0, 0x03, 0x0d
-    });*/
-
-    cpu->load(*game_code);
+    std::atomic<bool> running(true);
+    // Remplacer par ANIMATION_PROGRAM pour la dmo d'animation
+    cpu->load(SNAKE_PROGRAM);
     cpu->reset();
 
-    std::vector<uint8_t> screen_state(32 * 32 * 3, 0);
-    std::mt19937 rng(static_cast<unsigned>(time(nullptr)));
+    auto movie = std::make_unique<Movie>();
+    movie->seed = options.seed;
+    movie->program_hash = program_hash(SNAKE_PROGRAM);
 
-    while (*running)
+    // Un film enregistr ne peut pas tre rejou si la partie est revenue en arrire
+    std::unique_ptr<RewindBuffer> rewind;
+    if (options.record.empty()) {
+        rewind = std::make_unique<RewindBuffer>(REWIND_BUDGET);
+    }
+
+    FramePixels shown_pixels;
+    shown_pixels.fill(0);
+    std::vector<uint8_t> screen_state(FRAMEBUFFER_SIZE * 4, 0);
+    expand_palette(shown_pixels.data(), FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT, screen_state.data(), FRAMEBUFFER_WIDTH * 4);
+    uint32_t dirty_rows = 0xFFFFFFFF;
+
+    std::thread emulation(emulation_loop, std::ref(*cpu), std::ref(*bus), std::ref(*scheduler), std::ref(*keyboard), std::ref(*framebuffer), std::ref(*input), std::ref(*frames), std::ref(*movie), rewind.get(), std::ref(running));
+
+    // Ce thread ne fait plus que les messages et la prsentation : une attente du compositeur ne ralentit pas le CPU
+    while (running.load(std::memory_order_relaxed))
     {
         MSG msg = {};
         while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
             if (msg.message == WM_QUIT)
             {
-                *running = false;
+                running.store(false, std::memory_order_relaxed);
                 break;
             }
 
@@ -152,22 +240,20 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
             DispatchMessage(&msg);
         }
 
-        cpu->mem_write(0xFE, rng() % 16 + 1);
-
-        cpu->run(60);
-
-        if (read_screen_state(*cpu, screen_state))
-        {
-            renderer.RenderFrame(screen_state);
-        }
-        else
+        if (frames->update())
         {
-            renderer.RenderFrame(screen_state);
+            dirty_rows |= read_screen_state(frames->front(), shown_pixels, screen_state);
         }
+        renderer.RenderFrame(screen_state, dirty_rows);
+        dirty_rows = 0;
+    }
 
-        if (!cpu->is_cpu_running()) {
-            *running = false;
-        }
+    emulation.join();
+
+    if (!options.record.empty())
+    {
+        movie->end_cycle = scheduler->total_cycles();
+        movie->save(options.record);
     }
 
     renderer.CleanD3D();
@@ -176,22 +262,22 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-    static CPU* cpuPtr = nullptr;
+    static HostInput* inputPtr = nullptr;
 
     switch (uMsg)
     {
     case WM_CREATE:
     {
         CREATESTRUCT* pCreate = (CREATESTRUCT*)lParam;
-        cpuPtr = (CPU*)pCreate->lpCreateParams;
-        SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)cpuPtr);
+        inputPtr = (HostInput*)pCreate->lpCreateParams;
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)inputPtr);
     }
     break;
     case WM_DESTROY:
         PostQuitMessage(0);
         return 0;
     case WM_KEYDOWN:
-        if (cpuPtr)
+        if (inputPtr)
         {
             switch (wParam)
             {
@@ -199,22 +285,31 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 PostQuitMessage(0);
                 break;
             case 'Z':
-                cpuPtr->mem_write(0xFF, 0x77);
+                inputPtr->keys.push(0x77);
                 break;
             case 'S':
-                cpuPtr->mem_write(0xFF, 0x73);
+                inputPtr->keys.push(0x73);
                 break;
             case 'Q':
-                cpuPtr->mem_write(0xFF, 0x61);
+                inputPtr->keys.push(0x61);
                 break;
             case 'D':
-                cpuPtr->mem_write(0xFF, 0x64);
+                inputPtr->keys.push(0x64);
+                break;
+            case VK_BACK:
+                inputPtr->rewind_held.store(true, std::memory_order_relaxed);
                 break;
             default:
                 break;
             }
         }
         break;
+    case WM_KEYUP:
+        if (inputPtr && wParam == VK_BACK)
+        {
+            inputPtr->rewind_held.store(false, std::memory_order_relaxed);
+        }
+        break;
     default:
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
     }
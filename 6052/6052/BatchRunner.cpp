@@ -0,0 +1,145 @@
+#include "BatchRunner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+struct BatchRunner::Session {
+    Session(const ProgramImage& program, const Movie& inputs, uint64_t cycle_budget)
+        : cpu(bus), random(inputs.seed), movie(inputs), player(movie, keyboard), max_cycles(cycle_budget), finished(false) {
+        random.attach(bus);
+        keyboard.attach(bus);
+        framebuffer.attach(bus);
+        cpu.load(program);
+        cpu.reset();
+        result.stop = StopReason::Budget;
+        result.cycles = 0;
+        result.framebuffer.fill(0);
+    }
+
+    Bus bus;
+    CPU cpu;
+    RandomDevice random;
+    KeyboardLatch keyboard;
+    Framebuffer framebuffer;
+    Movie movie;
+    InputPlayer player;
+    uint64_t max_cycles;
+    bool finished;
+    BatchResult result;
+};
+
+BatchRunner::BatchRunner(const std::vector<uint8_t>& program_ref, unsigned threads, int slice_cycles)
+    : program(program_ref, PROGRAM_START), thread_count(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      slice(slice_cycles > 0 ? slice_cycles : DEFAULT_SLICE_CYCLES), elapsed(0) {
+    for (unsigned i = 0; i < thread_count; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+BatchRunner::~BatchRunner() = default;
+
+size_t BatchRunner::add(const Movie& inputs, uint64_t max_cycles) {
+    sessions.push_back(std::make_unique<Session>(program, inputs, max_cycles));
+    return sessions.size() - 1;
+}
+
+// Renvoie true s'il reste  excuter
+bool BatchRunner::run_slice(Session& session) {
+    int budget = slice;
+    if (session.max_cycles > 0) {
+        budget = static_cast<int>(std::min<uint64_t>(slice, session.max_cycles - session.result.cycles));
+    }
+    session.result.cycles += session.player.run(session.cpu, budget);
+
+    StopReason stop = session.cpu.stop_info().reason;
+    bool done = !session.cpu.is_cpu_running() || stop != StopReason::Budget ||
+        (session.max_cycles > 0 && session.result.cycles >= session.max_cycles);
+    if (done) {
+        session.result.stop = stop;
+        session.framebuffer.copy_pixels(session.result.framebuffer.data());
+        session.finished = true;
+    }
+    return !done;
+}
+
+bool BatchRunner::take(size_t worker, size_t& session) {
+    {
+        WorkQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.sessions.empty()) {
+            session = own.sessions.back();
+            own.sessions.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkQueue& victim = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.sessions.empty()) {
+            session = victim.sessions.front();
+            victim.sessions.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Une session ne cre jamais de travail et celle qu'un thread excute retourne dans sa propre file : quand plus
+// rien n'est  voler, les sessions restantes ont toutes un thread qui les mnera au bout, et ce worker peut s'arrter
+void BatchRunner::worker_loop(size_t worker) {
+    size_t index;
+    while (take(worker, index)) {
+        if (run_slice(*sessions[index])) {
+            WorkQueue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.sessions.push_back(index);
+        }
+    }
+}
+
+void BatchRunner::run() {
+    size_t pending = 0;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        if (!sessions[i]->finished) {
+            queues[pending % queues.size()]->sessions.push_back(i);
+            pending++;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    // Le thread appelant est le worker 0
+    std::vector<std::thread> workers;
+    for (size_t worker = 1; worker < queues.size(); ++worker) {
+        workers.emplace_back(&BatchRunner::worker_loop, this, worker);
+    }
+    worker_loop(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t BatchRunner::size() const {
+    return sessions.size();
+}
+
+const BatchResult& BatchRunner::result(size_t session) const {
+    return sessions[session]->result;
+}
+
+uint64_t BatchRunner::total_cycles() const {
+    uint64_t total = 0;
+    for (const auto& session : sessions) {
+        total += session->result.cycles;
+    }
+    return total;
+}
+
+double BatchRunner::elapsed_seconds() const {
+    return elapsed;
+}
+
+double BatchRunner::emulated_mhz() const {
+    return elapsed > 0 ? total_cycles() / elapsed / 1e6 : 0.0;
+}
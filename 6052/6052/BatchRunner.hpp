@@ -0,0 +1,74 @@
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include "Bus.hpp"
+#include "CPU.hpp"
+#include "Devices.hpp"
+#include "Movie.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Cycles excuts d'une traite par une session avant qu'elle ne retourne dans la file de son thread
+#define DEFAULT_SLICE_CYCLES 100000
+
+struct BatchResult {
+    StopReason stop;   // Budget si la session a atteint max_cycles
+    uint64_t cycles;
+    std::array<uint8_t, FRAMEBUFFER_SIZE> framebuffer;
+};
+
+// Sessions indpendantes d'un mme programme, chacune avec sa machine complte (bus, CPU, priphriques),
+// sa graine et ses touches (un Movie rejou au cycle prs). run() les excute par tranches sur tous les processeurs :
+// chaque thread a sa file de sessions, qu'il dpile par la fin, et vole par le dbut celles des autres une fois
+// la sienne vide. Une session ne touche qu' sa propre machine : les threads ne partagent que les files et,
+// en lecture seule, les pages du programme, que chaque session ne copie qu'en y crivant.
+class BatchRunner {
+public:
+    // threads = 0 : un thread par processeur logique
+    explicit BatchRunner(const std::vector<uint8_t>& program, unsigned threads = 0, int slice_cycles = DEFAULT_SLICE_CYCLES);
+    ~BatchRunner();
+
+    BatchRunner(const BatchRunner&) = delete;
+    BatchRunner& operator=(const BatchRunner&) = delete;
+
+    // Graine de $FE et touches prises dans inputs ; max_cycles = 0 : jusqu'au BRK. Renvoie l'indice de la session.
+    size_t add(const Movie& inputs, uint64_t max_cycles);
+    // Excute toutes les sessions pas encore termines jusqu' leur fin
+    void run();
+
+    size_t size() const;
+    const BatchResult& result(size_t session) const;
+
+    // Cumul de toutes les sessions et de tous les run()
+    uint64_t total_cycles() const;
+    double elapsed_seconds() const;
+    double emulated_mhz() const;
+
+private:
+    struct Session;
+
+    // File d'un thread : son propritaire travaille par la fin, les voleurs prennent au dbut
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> sessions;
+    };
+
+    bool run_slice(Session& session);
+    bool take(size_t worker, size_t& session);
+    void worker_loop(size_t worker);
+
+    ProgramImage program;
+    unsigned thread_count;
+    int slice;
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    double elapsed;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "BlockCache.hpp"
+
+#include <cstring>
+
+bool BlockCache::ends_block(const OpCode& opcode) {
+    switch (opcode.code) {
+    case 0x00: // BRK
+    case 0x20: // JSR
+    case 0x40: // RTI
+    case 0x4C: // JMP
+    case 0x60: // RTS
+    case 0x6C: // JMP (indirect)
+        return true;
+    default:
+        return opcode.mode == AddressingMode::Relative || opcode.handler == &CPU::TRAP<AddressingMode::Implied>;
+    }
+}
+
+bool BlockCache::writes_memory(const OpCode& opcode) {
+    static const char* const WRITERS[] = { "STA", "STX", "STY", "INC", "DEC", "ASL", "LSR", "ROL", "ROR", "PHA", "PHP", "JSR", "BRK" };
+
+    if (opcode.mode == AddressingMode::Accumulator) {
+        return false;
+    }
+    for (const char* writer : WRITERS) {
+        if (std::strcmp(opcode.mnemonic, writer) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BlockCache::may_read_device(const OpCode& opcode, uint16_t operand) const {
+    switch (opcode.mode) {
+    case AddressingMode::ZeroPage:
+    case AddressingMode::ZeroPage_X:
+    case AddressingMode::ZeroPage_Y:
+        return bus.read_page(0x00) == nullptr;
+    case AddressingMode::Absolute:
+        return bus.read_page(operand >> 8) == nullptr;
+    case AddressingMode::Absolute_X:
+    case AddressingMode::Absolute_Y:
+        return bus.read_page(operand >> 8) == nullptr || bus.read_page(static_cast<uint8_t>((operand >> 8) + 1)) == nullptr;
+    case AddressingMode::Indirect:
+    case AddressingMode::Indirect_X:
+    case AddressingMode::Indirect_Y:
+        // Adresse inconnue au dcodage : n'importe quelle page de priphrique peut tre lue
+        for (size_t page = 0; page < 0x100; ++page) {
+            if (bus.read_page(static_cast<uint8_t>(page)) == nullptr) {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+BlockCache::BlockCache(Bus& bus_ref) : bus(bus_ref), current_generation(0), breakpoints(nullptr) {
+    bus.set_code_write_listener([this](uint8_t page) { invalidate_page(page); });
+}
+
+BlockCache::~BlockCache() {
+    bus.set_code_write_listener(nullptr);
+}
+
+const DecodedBlock& BlockCache::fetch(uint16_t addr) {
+    std::unique_ptr<PageBlocks>& page = pages[addr >> 8];
+    if (!page) {
+        page = std::make_unique<PageBlocks>();
+    }
+
+    std::unique_ptr<DecodedBlock>& block = (*page)[addr & 0xFF];
+    if (!block) {
+        block = decode(addr);
+    }
+    return *block;
+}
+
+void BlockCache::invalidate_page(uint8_t page) {
+    // Un bloc peut dborder sur la page suivante, et la RAM est visible  travers ses miroirs
+    for (size_t logical = 0; logical < pages.size(); ++logical) {
+        if (!pages[logical]) {
+            continue;
+        }
+        uint16_t start = static_cast<uint16_t>(logical << 8);
+        uint8_t first = Bus::mirror_down(start) >> 8;
+        uint8_t next = Bus::mirror_down(static_cast<uint16_t>(start + 0x100)) >> 8;
+        if (first == page || next == page) {
+            pages[logical].reset();
+        }
+    }
+    current_generation++;
+}
+
+void BlockCache::clear() {
+    for (auto& page : pages) {
+        page.reset();
+    }
+    current_generation++;
+}
+
+void BlockCache::interrupt() {
+    current_generation++;
+}
+
+const uint32_t& BlockCache::generation() const {
+    return current_generation;
+}
+
+void BlockCache::set_breakpoints(const uint64_t* bitmap) {
+    breakpoints = bitmap;
+    clear();
+}
+
+std::unique_ptr<DecodedBlock> BlockCache::decode(uint16_t addr) const {
+    auto block = std::make_unique<DecodedBlock>();
+    block->cycles = 0;
+    block->idle_loop = IdleLoop::None;
+    block->counter_opcode = 0;
+
+    uint16_t start = addr;
+    uint8_t start_page = addr >> 8;
+    bool writes = false;
+    bool countdown_body = true;
+    const OpCode* opcode = nullptr;
+
+    bool reads_device = false;
+
+    // Le bloc ne quitte pas sa page : ses opcodes se lisent directement dans la table des pages
+    const uint8_t* code = bus.read_page(start_page);
+
+    while (block->instructions.size() < MAX_BLOCK_LENGTH) {
+        // run() ne vrifie les points d'arrt qu'en dbut de bloc
+        if (breakpoints && addr != start && (breakpoints[addr >> 6] >> (addr & 0x3F)) & 1) {
+            break;
+        }
+        opcode = &OPCODES_TABLE[code ? code[addr & 0xFF] : bus.peek(addr)];
+
+        DecodedInstruction instruction;
+        instruction.handler = opcode->handler;
+        instruction.address = addr;
+        instruction.code = opcode->code;
+        instruction.len = opcode->len;
+        instruction.cycles = opcode->cycles;
+        if (opcode->len == 2) {
+            instruction.operand = bus.peek(addr + 1);
+        }
+        else if (opcode->len == 3) {
+            instruction.operand = bus.peek(addr + 1) | (bus.peek(addr + 2) << 8);
+        }
+        else {
+            instruction.operand = 0;
+        }
+        block->instructions.push_back(instruction);
+        block->cycles += opcode->cycles;
+
+        for (uint8_t i = 0; i < opcode->len; ++i) {
+            bus.watch_code_page(addr + i);
+        }
+
+        writes = writes || writes_memory(*opcode);
+        reads_device = reads_device || may_read_device(*opcode, instruction.operand);
+        if (!ends_block(*opcode)) {
+            switch (opcode->code) {
+            case 0xEA: // NOP
+                break;
+            case 0xCA: // DEX
+            case 0x88: // DEY
+            case 0xE8: // INX
+            case 0xC8: // INY
+                countdown_body = countdown_body && block->counter_opcode == 0;
+                block->counter_opcode = opcode->code;
+                break;
+            default:
+                countdown_body = false;
+                break;
+            }
+        }
+
+        addr += opcode->len;
+        if (ends_block(*opcode) || (addr >> 8) != start_page) {
+            break;
+        }
+    }
+
+    // Dtection des boucles d'attente qui se rebouclent sur le dbut du bloc
+    const DecodedInstruction& last = block->instructions.back();
+    bool self_loop = false;
+    if (opcode->mode == AddressingMode::Relative) {
+        self_loop = static_cast<uint16_t>(last.address + 2 + static_cast<int8_t>(last.operand)) == start;
+    }
+    else if (opcode->code == 0x4C) {
+        self_loop = last.operand == start;
+    }
+
+    if (self_loop && opcode->code == 0xD0 && countdown_body && block->counter_opcode != 0) {
+        block->idle_loop = IdleLoop::Countdown;
+    }
+    else if (self_loop && !writes && !reads_device) {
+        block->idle_loop = IdleLoop::Poll;
+    }
+    // Chaque instance garde ses blocs : pas de capacit inutilise laisse par les push_back
+    block->instructions.shrink_to_fit();
+    return block;
+}
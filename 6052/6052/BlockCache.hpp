@@ -0,0 +1,47 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include "Bus.hpp"
+#include "OpCodes.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define MAX_BLOCK_LENGTH 32
+// Un bloc de MAX_BLOCK_LENGTH instructions de 7 cycles : plus grand dpassement possible du budget de run()
+#define MAX_BLOCK_CYCLES (MAX_BLOCK_LENGTH * 7)
+
+class BlockCache {
+public:
+    explicit BlockCache(Bus& bus_ref);
+    ~BlockCache();
+
+    const DecodedBlock& fetch(uint16_t addr);
+    void invalidate_page(uint8_t page);
+    void clear();
+    // Fait sortir du bloc en cours d'excution aprs l'instruction courante, sans rien invalider
+    void interrupt();
+
+    // Incrment  chaque invalidation ou interruption : un bloc en cours d'excution s'arrte s'il a chang
+    const uint32_t& generation() const;
+
+    // Bitmap de 64 Kbit des points d'arrt, nullptr sans point d'arrt : chacun commence un bloc
+    void set_breakpoints(const uint64_t* bitmap);
+
+private:
+    using PageBlocks = std::array<std::unique_ptr<DecodedBlock>, 0x100>;
+
+    static bool ends_block(const OpCode& opcode);
+    static bool writes_memory(const OpCode& opcode);
+    bool may_read_device(const OpCode& opcode, uint16_t operand) const;
+    std::unique_ptr<DecodedBlock> decode(uint16_t addr) const;
+
+    Bus& bus;
+    std::array<std::unique_ptr<PageBlocks>, 0x100> pages;
+    uint32_t current_generation;
+    const uint64_t* breakpoints;
+};
+
+#endif
@@ -1,54 +1,436 @@
 #include "Bus.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 
 #define RAM_START 0x0000
 #define RAM_MIRRORS_END 0x1FFF
-#define PPU_REGISTERS_START 0x2000
-#define PPU_REGISTERS_MIRRORS_END 0x3FFF
+#define MAX_DEVICES 0xFF
 
-Bus::Bus() {
-    memory.fill(0);
+// Page de zros commune  tous les bus, jamais crite : chacun en copie une avant d'y crire
+static const std::shared_ptr<MemoryPage>& blank_page() {
+    static const std::shared_ptr<MemoryPage> page = std::make_shared<MemoryPage>(MemoryPage{});
+    return page;
+}
+
+ProgramImage::ProgramImage(const std::vector<uint8_t>& program, uint16_t start_addr_ref) : start_addr(start_addr_ref), size(program.size()) {
+    if (size > static_cast<size_t>(0x10000 - start_addr)) {
+        std::cerr << "Programme hors de la RAM tronqu  $FFFF" << std::endl;
+        size = 0x10000 - start_addr;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        size_t addr = start_addr + i;
+        std::shared_ptr<MemoryPage>& page = pages[addr >> 8];
+        if (!page) {
+            page = std::make_shared<MemoryPage>(MemoryPage{});
+        }
+        (*page)[addr & 0xFF] = program[i];
+    }
+}
+
+uint16_t ProgramImage::start() const {
+    return start_addr;
+}
+
+// Cl de Zobrist de data  l'adresse physique addr, calcule plutt que lue dans une table de 16 M cls ;
+// nulle pour un octet  zro
+static uint64_t hash_key(size_t addr, uint8_t data) {
+    return data ? Bus::mix_hash(static_cast<uint64_t>(addr) << 8 | data) : 0;
+}
+
+Bus::Bus() : contiguous_ram(false), hashing(false), ram_hash_value(0) {
+    memory.fill(blank_page());
+    page_devices.fill(0);
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
+void Bus::map_page(uint8_t page) {
+    uint16_t physical = mirror_down(static_cast<uint16_t>(page << 8));
+    uint8_t index = physical >> 8;
+    uint8_t* data = memory[index]->data() + (physical & 0xFF);
+    bool watch_read = watchpoints && watchpoints->read_pages[index];
+    bool watch_write = watchpoints && watchpoints->write_pages[index];
+    read_pages[page] = (device_read_pages[index] || watch_read) ? nullptr : data;
+    write_pages[page] = (!private_pages[index] || code_pages[index] || device_write_pages[index] || watch_write || hashing) ? nullptr : data;
+}
+
+void Bus::map_physical_page(uint8_t physical) {
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        if (mirror_down(static_cast<uint16_t>(page << 8)) >> 8 == physical) {
+            map_page(static_cast<uint8_t>(page));
+        }
+    }
+}
+
+// Copie prive de la page physique  sa premire criture ; la table des pages suit le nouveau pointeur.
+// Une page partage dont ce bus est rest le seul dtenteur (machine ou image de programme dtruite) est reprise
+// telle quelle, sans copie
+uint8_t* Bus::writable_page(uint8_t physical) {
+    if (!private_pages[physical]) {
+        if (memory[physical].use_count() == 1) {
+            // Voit les critures faites par l'ancien dtenteur avant de relcher la page
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        else {
+            memory[physical] = std::make_shared<MemoryPage>(*memory[physical]);
+        }
+        private_pages[physical] = true;
+        map_physical_page(physical);
+    }
+    return memory[physical]->data();
 }
 
 void Bus::load_program(const std::vector<uint8_t>& program, uint16_t start_addr) {
-    std::copy(program.begin(), program.end(), memory.begin() + start_addr);
+    write_ram(start_addr, program.data(), program.size());
+}
+
+void Bus::load_image(const ProgramImage& image) {
+    if (image.size == 0) {
+        return;
+    }
+    size_t end = image.start_addr + image.size;
+    for (size_t page = image.start_addr >> 8; page <= (end - 1) >> 8; ++page) {
+        // Une page vierge, zros compris autour du programme, est exactement celle de l'image
+        if (memory[page] == blank_page()) {
+            memory[page] = image.pages[page];
+            if (hashing) {
+                for (size_t i = 0; i < 0x100; ++i) {
+                    ram_hash_value ^= hash_key((page << 8) | i, (*memory[page])[i]);
+                }
+            }
+            map_physical_page(static_cast<uint8_t>(page));
+            if (code_pages[page]) {
+                notify_code_write(static_cast<uint8_t>(page));
+            }
+            continue;
+        }
+        size_t first = std::max<size_t>(page << 8, image.start_addr);
+        size_t last = std::min<size_t>((page << 8) + 0x100, end);
+        write_ram(static_cast<uint16_t>(first), image.pages[page]->data() + (first & 0xFF), last - first);
+    }
+}
+
+void Bus::read_ram(uint16_t addr, uint8_t* data, size_t size) const {
+    size = std::min<size_t>(size, 0x10000 - addr);
+    for (size_t pos = addr, end = addr + size; pos < end; ) {
+        size_t chunk = std::min<size_t>(0x100 - (pos & 0xFF), end - pos);
+        std::memcpy(data, memory[pos >> 8]->data() + (pos & 0xFF), chunk);
+        data += chunk;
+        pos += chunk;
+    }
+}
+
+void Bus::write_ram(uint16_t addr, const uint8_t* data, size_t size) {
+    if (size > static_cast<size_t>(0x10000 - addr)) {
+        std::cerr << "criture hors de la RAM tronque  $FFFF" << std::endl;
+        size = 0x10000 - addr;
+    }
+
+    // Une page qui garde son contenu, souvent le cas en restaurant un tat, reste partage et ses blocs dcods valables
+    for (size_t pos = addr, end = addr + size; pos < end; ) {
+        uint8_t page = static_cast<uint8_t>(pos >> 8);
+        size_t chunk = std::min<size_t>(0x100 - (pos & 0xFF), end - pos);
+        if (std::memcmp(memory[page]->data() + (pos & 0xFF), data, chunk) != 0) {
+            uint8_t* target = writable_page(page) + (pos & 0xFF);
+            if (hashing) {
+                for (size_t i = 0; i < chunk; ++i) {
+                    ram_hash_value ^= hash_key(pos + i, target[i]) ^ hash_key(pos + i, data[i]);
+                }
+            }
+            std::memcpy(target, data, chunk);
+            if (code_pages[page]) {
+                notify_code_write(page);
+            }
+        }
+        data += chunk;
+        pos += chunk;
+    }
+}
+
+void Bus::use_contiguous_ram(const std::shared_ptr<MemoryPage[]>& storage, size_t first_page) {
+    for (size_t page = 0; page < memory.size(); ++page) {
+        MemoryPage& target = storage[first_page + page];
+        target = *memory[page];
+        // Les pages pointent dans storage et en partagent le compteur de rfrences
+        memory[page] = std::shared_ptr<MemoryPage>(storage, &target);
+        private_pages[page] = true;
+    }
+    contiguous_ram = true;
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
+void Bus::share_ram(Bus& source) {
+    if (contiguous_ram || source.contiguous_ram) {
+        for (size_t page = 0; page < memory.size(); ++page) {
+            write_ram(static_cast<uint16_t>(page << 8), source.memory[page]->data(), 0x100);
+        }
+        if (source.hashing) {
+            enable_ram_hash();
+        }
+        return;
+    }
+
+    for (size_t page = 0; page < memory.size(); ++page) {
+        source.private_pages[page] = false;
+        private_pages[page] = false;
+        if (memory[page] != source.memory[page]) {
+            memory[page] = source.memory[page];
+            if (code_pages[page]) {
+                notify_code_write(static_cast<uint8_t>(page));
+            }
+        }
+    }
+    // Une empreinte suit la RAM : celle de source vaut pour les deux bus
+    if (source.hashing) {
+        hashing = true;
+        ram_hash_value = source.ram_hash_value;
+    }
+    else if (hashing) {
+        ram_hash_value = compute_ram_hash();
+    }
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+        source.map_page(static_cast<uint8_t>(page));
+    }
 }
 
-uint8_t Bus::mem_read(uint16_t addr) const {
+uint16_t Bus::mirror_down(uint16_t addr) {
     if (addr >= RAM_START && addr <= RAM_MIRRORS_END) {
-        uint16_t mirror_down_addr = addr & 0x07FF;
-        return memory[mirror_down_addr];
+        return addr & 0x07FF;
+    }
+    return addr;
+}
+
+void Bus::watch_code_page(uint16_t addr) {
+    uint8_t physical = mirror_down(addr) >> 8;
+    if (code_pages[physical]) {
+        return;
+    }
+
+    // Les critures dans la page et dans tous ses miroirs passent dsormais par le chemin lent
+    code_pages[physical] = true;
+    map_physical_page(physical);
+}
+
+void Bus::set_code_write_listener(std::function<void(uint8_t)> listener) {
+    code_write_listener = std::move(listener);
+}
+
+void Bus::notify_code_write(uint8_t page) {
+    code_pages[page] = false;
+    map_physical_page(page);
+
+    if (code_write_listener) {
+        code_write_listener(page);
+    }
+}
+
+void Bus::map_device(uint16_t start, uint16_t end, DeviceRead read, DeviceWrite write) {
+    if (devices.size() >= MAX_DEVICES) {
+        std::cerr << "Trop de priphriques projets sur le bus !" << std::endl;
+        return;
     }
-    /*
-    else if (addr >= PPU_REGISTERS_START && addr <= PPU_REGISTERS_MIRRORS_END) {
-        uint16_t mirror_down_addr = addr & 0x2007;
-        std::cerr << "Accs aux registres PPU non implment !" << std::endl;
+    bool reads = static_cast<bool>(read);
+    bool writes = static_cast<bool>(write);
+    devices.push_back({ std::move(read), std::move(write) });
+    uint8_t slot = static_cast<uint8_t>(devices.size());
+
+    for (uint32_t addr = start; addr <= end; ++addr) {
+        uint16_t physical = mirror_down(static_cast<uint16_t>(addr));
+        uint8_t page = physical >> 8;
+        if (!device_table_pages[page]) {
+            device_tables.emplace_back();
+            device_tables.back().fill(page_devices[page]);
+            page_devices[page] = static_cast<uint8_t>(device_tables.size() - 1);
+            device_table_pages[page] = true;
+        }
+        device_tables[page_devices[page]][physical & 0xFF] = slot;
+        device_read_pages[page] = device_read_pages[page] || reads;
+        device_write_pages[page] = device_write_pages[page] || writes;
+    }
+    compact_device_tables();
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+
+    // Les blocs dj dcods ont pu prendre une lecture de ce priphrique pour une boucle d'attente
+    for (size_t page = 0; page < code_pages.size(); ++page) {
+        if (code_pages[page]) {
+            notify_code_write(static_cast<uint8_t>(page));
+        }
+    }
+}
+
+// Une page couverte par un seul priphrique (ou aucun) n'a pas besoin de table par octet
+void Bus::compact_device_tables() {
+    std::vector<std::array<uint8_t, 0x100>> kept;
+    for (size_t page = 0; page < page_devices.size(); ++page) {
+        if (!device_table_pages[page]) {
+            continue;
+        }
+        const std::array<uint8_t, 0x100>& table = device_tables[page_devices[page]];
+        if (std::all_of(table.begin(), table.end(), [&](uint8_t slot) { return slot == table[0]; })) {
+            page_devices[page] = table[0];
+            device_table_pages[page] = false;
+        }
+        else {
+            kept.push_back(table);
+            page_devices[page] = static_cast<uint8_t>(kept.size() - 1);
+        }
+    }
+    device_tables = std::move(kept);
+}
+
+void Bus::add_watchpoint(uint16_t start, uint16_t end, uint8_t kinds) {
+    if (!watchpoints) {
+        watchpoints = std::make_unique<Watchpoints>();
+    }
+    for (uint32_t addr = start; addr <= end; ++addr) {
+        uint16_t physical = mirror_down(static_cast<uint16_t>(addr));
+        std::unique_ptr<std::array<uint8_t, 0x100>>& slots = watchpoints->slots[physical >> 8];
+        if (!slots) {
+            slots = std::make_unique<std::array<uint8_t, 0x100>>();
+            slots->fill(0);
+        }
+        (*slots)[physical & 0xFF] |= kinds;
+        watchpoints->read_pages[physical >> 8] = watchpoints->read_pages[physical >> 8] || (kinds & WATCH_READ) != 0;
+        watchpoints->write_pages[physical >> 8] = watchpoints->write_pages[physical >> 8] || (kinds & WATCH_WRITE) != 0;
+    }
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
+void Bus::clear_watchpoints() {
+    watchpoints.reset();
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
+bool Bus::has_watchpoints() const {
+    return watchpoints != nullptr;
+}
+
+void Bus::set_watch_listener(WatchListener listener) {
+    watch_listener = std::move(listener);
+}
+
+uint64_t Bus::mix_hash(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+uint64_t Bus::compute_ram_hash() const {
+    uint64_t hash = 0;
+    for (size_t page = 0; page < memory.size(); ++page) {
+        if (memory[page] == blank_page()) {
+            continue;
+        }
+        for (size_t i = 0; i < 0x100; ++i) {
+            hash ^= hash_key((page << 8) | i, (*memory[page])[i]);
+        }
+    }
+    return hash;
+}
+
+void Bus::enable_ram_hash() {
+    if (hashing) {
+        return;
+    }
+    hashing = true;
+    ram_hash_value = compute_ram_hash();
+    // Toutes les critures passent dsormais par le chemin lent, qui tient l'empreinte  jour
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
+void Bus::disable_ram_hash() {
+    hashing = false;
+    for (size_t page = 0; page < read_pages.size(); ++page) {
+        map_page(static_cast<uint8_t>(page));
+    }
+}
+
+bool Bus::has_ram_hash() const {
+    return hashing;
+}
+
+uint64_t Bus::ram_hash() const {
+    return ram_hash_value;
+}
+
+const Bus::Device* Bus::find_device(uint16_t physical) const {
+    uint8_t page = physical >> 8;
+    uint8_t slot = device_table_pages[page] ? device_tables[page_devices[page]][physical & 0xFF] : page_devices[page];
+    return slot ? &devices[slot - 1] : nullptr;
+}
+
+uint8_t Bus::watch_kinds(uint16_t physical) const {
+    if (!watchpoints) {
         return 0;
-    }*/
-    else {
-        return memory[addr];
     }
+    const std::unique_ptr<std::array<uint8_t, 0x100>>& slots = watchpoints->slots[physical >> 8];
+    return slots ? (*slots)[physical & 0xFF] : 0;
 }
 
-void Bus::mem_write(uint16_t addr, uint8_t data) {
-    if (addr >= RAM_START && addr <= RAM_MIRRORS_END) {
-        uint16_t mirror_down_addr = addr & 0x07FF;
-        memory[mirror_down_addr] = data;
-    }/*
-    else if (addr >= PPU_REGISTERS_START && addr <= PPU_REGISTERS_MIRRORS_END) {
-        uint16_t mirror_down_addr = addr & 0x2007;
-        std::cerr << "Accs en criture aux registres PPU non implment !" << std::endl;
-    }*/
-    else {
-        memory[addr] = data;
-    }
-}
-
-uint16_t Bus::mem_read_u16(uint16_t addr) const {
-    uint8_t lo = mem_read(addr);
-    uint8_t hi = mem_read(addr + 1);
-    return (hi << 8) | lo;
+uint8_t Bus::peek(uint16_t addr) const {
+    uint16_t physical = mirror_down(addr);
+    return (*memory[physical >> 8])[physical & 0xFF];
+}
+
+const uint8_t* Bus::ram(uint16_t addr) const {
+    uint16_t physical = mirror_down(addr);
+    return memory[physical >> 8]->data() + (physical & 0xFF);
+}
+
+bool Bus::read_has_side_effects(uint16_t addr) const {
+    uint16_t physical = mirror_down(addr);
+    const Device* device = find_device(physical);
+    return (device && device->read) || (watch_kinds(physical) & WATCH_READ);
+}
+
+uint8_t Bus::mem_read_slow(uint16_t addr) const {
+    uint16_t physical = mirror_down(addr);
+    if ((watch_kinds(physical) & WATCH_READ) && watch_listener) {
+        watch_listener(addr, false);
+    }
+    const Device* device = find_device(physical);
+    if (device && device->read) {
+        return device->read(physical);
+    }
+    return (*memory[physical >> 8])[physical & 0xFF];
+}
+
+void Bus::mem_write_slow(uint16_t addr, uint8_t data) {
+    uint16_t physical = mirror_down(addr);
+    if ((watch_kinds(physical) & WATCH_WRITE) && watch_listener) {
+        watch_listener(addr, true);
+    }
+    const Device* device = find_device(physical);
+    if (device && device->write) {
+        device->write(physical, data);
+    }
+    if (!device || !device->read) {
+        uint8_t& byte = writable_page(physical >> 8)[physical & 0xFF];
+        if (hashing) {
+            ram_hash_value ^= hash_key(physical, byte) ^ hash_key(physical, data);
+        }
+        byte = data;
+    }
+
+    if (code_pages[physical >> 8]) {
+        notify_code_write(physical >> 8);
+    }
 }
 
 void Bus::mem_write_u16(uint16_t addr, uint16_t data) {
@@ -2,11 +2,44 @@
 #define BUS_HPP
 
 #include <array>
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 
+using MemoryPage = std::array<uint8_t, 0x100>;
+
+enum WatchKind : uint8_t {
+    WATCH_READ  = 0x01,
+    WATCH_WRITE = 0x02,
+};
+
+// Programme dcoup en pages une fois pour toutes, pour le charger dans de nombreux bus : ils partagent ses pages
+// en lecture seule et chacun ne copie une page qu' sa premire criture dedans
+class ProgramImage {
+public:
+    ProgramImage(const std::vector<uint8_t>& program, uint16_t start_addr);
+
+    uint16_t start() const;
+
+private:
+    friend class Bus;
+
+    uint16_t start_addr;
+    size_t size;
+    // Jamais modifies ; nullptr pour les pages que le programme ne touche pas
+    std::array<std::shared_ptr<MemoryPage>, 0x100> pages;
+};
+
 class Bus {
 public:
+    using DeviceRead = std::function<uint8_t(uint16_t addr)>;
+    using DeviceWrite = std::function<void(uint16_t addr, uint8_t data)>;
+    // Adresse vue par le CPU et sens de l'accs surveill
+    using WatchListener = std::function<void(uint16_t addr, bool write)>;
+
     Bus();
 
     uint8_t mem_read(uint16_t addr) const;
@@ -16,9 +49,140 @@ public:
     void mem_write_u16(uint16_t addr, uint16_t data);
 
     void load_program(const std::vector<uint8_t>& program, uint16_t start_addr);
+    // Comme load_program, mais les pages encore vierges du bus reprennent celles de l'image sans copie
+    void load_image(const ProgramImage& image);
+
+    static uint16_t mirror_down(uint16_t addr);
+
+    // Projette un priphrique sur [start, end] : un callback vide laisse ce sens d'accs  la RAM.
+    // Sans callback de lecture, write ne fait qu'observer : il est appel avant que la RAM ne prenne la valeur.
+    void map_device(uint16_t start, uint16_t end, DeviceRead read, DeviceWrite write);
+
+    // Lecture de la RAM sans passer par les priphriques, pour le dcodage et le dsassemblage
+    uint8_t peek(uint16_t addr) const;
+    // Pointeur dans la RAM physique de addr, contigu jusqu' la fin de sa page (jusqu' $FFFF aprs use_contiguous_ram).
+    // Il n'est plus valable aprs une criture dans une page encore partage, qui en fait une copie prive
+    const uint8_t* ram(uint16_t addr) const;
+    // Copie de la RAM physique  partir de addr, sans priphriques
+    void read_ram(uint16_t addr, uint8_t* data, size_t size) const;
+    // Copie dans la RAM physique  partir de addr, sans priphriques ; les blocs dcods des pages modifies sont invalids
+    void write_ram(uint16_t addr, const uint8_t* data, size_t size);
+
+    // Installe la RAM dans les 256 pages conscutives de storage  partir de first_page, prives et contigus jusqu'
+    // $FFFF, pour un moteur qui l'adresse directement (Lockstep) ; le bus garde storage en vie et ne partage plus ses pages
+    void use_contiguous_ram(const std::shared_ptr<MemoryPage[]>& storage, size_t first_page);
+    // Remplace la RAM par celle de source sans la copier : les pages deviennent partages entre les deux bus et chacun
+    // copie une page  sa premire criture dedans. Une RAM contigu, elle, est copie
+    void share_ram(Bus& source);
+
+    // Vrai si une lecture de addr par le CPU ne se rsume pas  la RAM : priphrique ou surveillance en lecture
+    bool read_has_side_effects(uint16_t addr) const;
+    // Contenu de la page pour une lecture directe, nullptr si sa lecture passe par le chemin lent
+    const uint8_t* read_page(uint8_t page) const;
+
+    // Pages prdcodes par le cache de blocs : la premire criture dans l'une d'elles est signale au listener
+    void watch_code_page(uint16_t addr);
+    void set_code_write_listener(std::function<void(uint8_t)> listener);
+
+    // Points de surveillance sur [start, end], miroirs compris : seules leurs pages passent par le chemin lent,
+    // qui signale au listener chaque accs du CPU aux octets surveills (WATCH_READ et/ou WATCH_WRITE)
+    void add_watchpoint(uint16_t start, uint16_t end, uint8_t kinds);
+    void clear_watchpoints();
+    bool has_watchpoints() const;
+    void set_watch_listener(WatchListener listener);
+
+    // Empreinte de Zobrist des 64 Ko de RAM physique, lue en O(1) : calcule une fois  l'activation puis tenue  jour
+    //  chaque criture, qui passe alors par le chemin lent. Nulle pour une RAM  zro
+    void enable_ram_hash();
+    void disable_ram_hash();
+    bool has_ram_hash() const;
+    uint64_t ram_hash() const;
+    // Mlange de 64 bits des cls de l'empreinte (splitmix64), rutilis pour les registres du CPU
+    static uint64_t mix_hash(uint64_t value);
 
 private:
-    std::array<uint8_t, 0x10000> memory;
+    uint8_t mem_read_slow(uint16_t addr) const;
+    void mem_write_slow(uint16_t addr, uint8_t data);
+    void map_page(uint8_t page);
+    void map_physical_page(uint8_t physical);
+    void notify_code_write(uint8_t page);
+    uint8_t* writable_page(uint8_t physical);
+    uint64_t compute_ram_hash() const;
+
+    struct Device {
+        DeviceRead read;
+        DeviceWrite write;
+    };
+    const Device* find_device(uint16_t physical) const;
+    uint8_t watch_kinds(uint16_t physical) const;
+    void compact_device_tables();
+
+    // Pages physiques, partages en lecture seule (page vierge commune, image de programme) jusqu' leur premire
+    // criture, qui en fait une copie prive au bus
+    std::array<std::shared_ptr<MemoryPage>, 0x100> memory;
+    std::bitset<0x100> private_pages;
+    bool contiguous_ram;
+
+    // Table des pages : les miroirs pointent sur la mme page physique, nullptr renvoie vers le chemin lent
+    std::array<uint8_t*, 0x100> read_pages;
+    std::array<uint8_t*, 0x100> write_pages;
+
+    std::vector<Device> devices;
+    // Indice + 1 du priphrique de toute la page physique ; pour les pages partages entre plusieurs priphriques
+    // (bit de device_table_pages), indice de leur table par octet dans device_tables
+    std::array<uint8_t, 0x100> page_devices;
+    std::bitset<0x100> device_table_pages;
+    std::vector<std::array<uint8_t, 0x100>> device_tables;
+    std::bitset<0x100> device_read_pages;
+    std::bitset<0x100> device_write_pages;
+
+    std::bitset<0x100> code_pages;
+    std::function<void(uint8_t)> code_write_listener;
+
+    // Allous au premier point de surveillance : la plupart des bus n'en ont jamais
+    struct Watchpoints {
+        // WatchKind de chaque octet, allou seulement pour les pages physiques surveilles
+        std::array<std::unique_ptr<std::array<uint8_t, 0x100>>, 0x100> slots;
+        std::bitset<0x100> read_pages;
+        std::bitset<0x100> write_pages;
+    };
+    std::unique_ptr<Watchpoints> watchpoints;
+    WatchListener watch_listener;
+
+    bool hashing;
+    uint64_t ram_hash_value;
 };
 
+inline uint8_t Bus::mem_read(uint16_t addr) const {
+    const uint8_t* page = read_pages[addr >> 8];
+    if (page) {
+        return page[addr & 0xFF];
+    }
+    return mem_read_slow(addr);
+}
+
+inline void Bus::mem_write(uint16_t addr, uint8_t data) {
+    uint8_t* page = write_pages[addr >> 8];
+    if (page) {
+        page[addr & 0xFF] = data;
+    }
+    else {
+        mem_write_slow(addr, data);
+    }
+}
+
+inline uint16_t Bus::mem_read_u16(uint16_t addr) const {
+    const uint8_t* page = read_pages[addr >> 8];
+    if (page && (addr & 0xFF) != 0xFF) {
+        return page[addr & 0xFF] | (page[(addr & 0xFF) + 1] << 8);
+    }
+    uint8_t lo = mem_read(addr);
+    uint8_t hi = mem_read(addr + 1);
+    return (hi << 8) | lo;
+}
+
+inline const uint8_t* Bus::read_page(uint8_t page) const {
+    return read_pages[page];
+}
+
 #endif
@@ -1,6 +1,8 @@
 #include "CPU.hpp"
+#include "BlockCache.hpp"
 #include "OpCodes.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <thread>
@@ -8,27 +10,71 @@
 #define STACK 0x0100
 #define STACK_RESET 0xFD
 
-CPU::CPU(Bus& bus_ref) : bus(bus_ref), is_running(true) {
+CPU::CPU(Bus& bus_ref)
+    : bus(bus_ref), block_cache(std::make_unique<BlockCache>(bus_ref)), block_generation(&block_cache->generation()), is_running(true), poll_state(), cycles_skipped(0),
+      breakpoint_count(0), debug_armed(false), watch_hit(false), watch_stop(), last_stop{ StopReason::Budget, 0, MemoryAccess::None } {
+    bus.set_watch_listener([this](uint16_t addr, bool write) { on_watch(addr, write); });
     reset();
 }
 
+CPU::~CPU() {
+    bus.set_watch_listener(nullptr);
+}
+
 void CPU::reset() {
     register_a = 0;
     register_x = 0;
     register_y = 0;
     stack_pointer = STACK_RESET;
-    status = 0x24;
+    set_status(0x24);
     program_counter = mem_read_u16(0xFFFC);
     is_running = true;
+    last_stop = { StopReason::Budget, 0, MemoryAccess::None };
 }
 
 void CPU::load(const std::vector<uint8_t>& program) {
-    bus.load_program(program, 0x0600);
-    mem_write_u16(0xFFFC, 0x0600);
+    bus.load_program(program, PROGRAM_START);
+    mem_write_u16(0xFFFC, PROGRAM_START);
+}
+
+void CPU::load(const ProgramImage& image) {
+    bus.load_image(image);
+    mem_write_u16(0xFFFC, image.start());
+}
+
+int CPU::run(int max_cycles) {
+    return run_with_callback(NoHook(), max_cycles);
 }
 
-void CPU::run(int max_cycles) {
-    run_with_callback([](CPU&) {}, max_cycles);
+int CPU::step() {
+    if (!is_running) {
+        return 0;
+    }
+    uint16_t address = program_counter;
+    const OpCode& opcode = OPCODES_TABLE[bus.peek(address)];
+    uint16_t operand = 0;
+    if (opcode.len == 2) {
+        operand = bus.peek(address + 1);
+    }
+    else if (opcode.len == 3) {
+        operand = bus.peek(address + 1) | (bus.peek(address + 2) << 8);
+    }
+
+    load_status_flags();
+    last_stop = { StopReason::Budget, 0, MemoryAccess::None };
+    uint16_t program_counter_state = address + 1;
+    program_counter = program_counter_state;
+    (this->*opcode.handler)(operand);
+    if (!is_running) {
+        if (last_stop.reason == StopReason::Budget) {
+            last_stop = { StopReason::Halted, address, MemoryAccess::None };
+        }
+    }
+    else if (program_counter == program_counter_state) {
+        program_counter += (opcode.len - 1);
+    }
+    materialize_status();
+    return opcode.cycles;
 }
 
 void CPU::load_and_run(const std::vector<uint8_t>& program) {
@@ -37,370 +83,198 @@ void CPU::load_and_run(const std::vector<uint8_t>& program) {
     run();
 }
 
-void CPU::run_with_callback(std::function<void(CPU&)> callback, int max_cycles) {
-    int cycles = 0;
-    while (true) {
-        uint8_t code = mem_read(program_counter++);
-        uint16_t program_counter_state = program_counter;
-        const OpCode* opcode = OPCODES_MAP.at(code);
-
-        switch (code) {
-        case 0x69:
-        case 0x65:
-        case 0x75:
-        case 0x6D:
-        case 0x7D:
-        case 0x79:
-        case 0x61:
-        case 0x71:
-            ADC(opcode->mode);
-            break;
-
-        case 0x29:
-        case 0x25:
-        case 0x35:
-        case 0x2D:
-        case 0x3D:
-        case 0x39:
-        case 0x21:
-        case 0x31:
-            AND(opcode->mode);
-            break;
-
-        case 0x0A:
-        case 0x06:
-        case 0x16:
-        case 0x0E:
-        case 0x1E:
-            ASL(opcode->mode);
-            break;
-
-            // BCC
-        case 0x90:
-            Branch(!(status & 0x01));
-            break;
-
-            // BCS
-        case 0xB0:
-            Branch(status & 0x01);
-            break;
-
-            // BEQ
-        case 0xF0:
-            Branch(status & 0x02);
-            break;
-
-        case 0x24:
-        case 0x2C:
-            BIT(opcode->mode);
-            break;
-
-            // BMI
-        case 0x30:
-            Branch(status & 0x80);
-            break;
-
-            // BNE
-        case 0xD0:
-            Branch(!(status & 0x02));
-            break;
-
-            // BPL
-        case 0x10:
-            Branch(!(status & 0x80));
-            break;
-
-            // BRK
-        case 0x00:
-            is_running = false;
-            return;
-
-            // BVC
-        case 0x50:
-            Branch(!(status & 0x40));
-            break;
-
-            // BVS
-        case 0x70:
-            Branch(status & 0x40);
-            break;
-
-        case 0x18:
-            CLC();
-            break;
-
-            // CLD
-        case 0xD8:
-            status &= ~0x08;
-            break;
-
-            // CLI
-        case 0x58:
-            status &= ~0x04;
-            break;
-
-            // CLV
-        case 0xB8:
-            status &= ~0x40;
-            break;
-
-        case 0xC9:
-        case 0xC5:
-        case 0xD5:
-        case 0xCD:
-        case 0xDD:
-        case 0xD9:
-        case 0xC1:
-        case 0xD1:
-            CMP(opcode->mode);
-            break;
-
-        case 0xE0:
-        case 0xE4:
-        case 0xEC:
-            CPX(opcode->mode);
-            break;
-
-        case 0xC0:
-        case 0xC4:
-        case 0xCC:
-            CPY(opcode->mode);
-            break;
-
-        case 0xC6:
-        case 0xD6:
-        case 0xCE:
-        case 0xDE:
-            DEC(opcode->mode);
-            break;
-
-        case 0xCA:
-            DEX();
-            break;
-
-        case 0x88:
-            DEY();
-            break;
-
-        case 0x49:
-        case 0x45:
-        case 0x55:
-        case 0x4D:
-        case 0x5D:
-        case 0x59:
-        case 0x41:
-        case 0x51:
-            EOR(opcode->mode);
-            break;
-
-        case 0xE6:
-        case 0xF6:
-        case 0xEE:
-        case 0xFE:
-            INC(opcode->mode);
-            break;
-
-        case 0xE8:
-            INX();
-            break;
-
-        case 0xC8:
-            INY();
-            break;
-
-        case 0x4C:
-        case 0x6C:
-            JMP(opcode->mode);
-            break;
-
-        case 0x20:
-            JSR(opcode->mode);
-            break;
-
-        case 0xA9:
-        case 0xA5:
-        case 0xB5:
-        case 0xAD:
-        case 0xBD:
-        case 0xB9:
-        case 0xA1:
-        case 0xB1:
-            LDA(opcode->mode);
-            break;
-
-        case 0xA2:
-        case 0xA6:
-        case 0xB6:
-        case 0xAE:
-        case 0xBE:
-            LDX(opcode->mode);
-            break;
-
-        case 0xA0:
-        case 0xA4:
-        case 0xB4:
-        case 0xAC:
-        case 0xBC:
-            LDY(opcode->mode);
-            break;
-
-        case 0x4A:
-        case 0x46:
-        case 0x56:
-        case 0x4E:
-        case 0x5E:
-            LSR(opcode->mode);
-            break;
-
-            // NOP
-        case 0xEA:
-            break;
-
-        case 0x09:
-        case 0x05:
-        case 0x15:
-        case 0x0D:
-        case 0x1D:
-        case 0x19:
-        case 0x01:
-        case 0x11:
-            ORA(opcode->mode);
-            break;
-
-            // PHA
-        case 0x48:
-            stack_push(register_a);
-            break;
-
-        case 0x08:
-            PHP();
-            break;
-
-        case 0x68:
-            PLA();
-            break;
-
-        case 0x28:
-            PLP();
-            break;
-
-        case 0x2A:
-        case 0x26:
-        case 0x36:
-        case 0x2E:
-        case 0x3E:
-            ROL(opcode->mode);
-            break;
-
-        case 0x6A:
-        case 0x66:
-        case 0x76:
-        case 0x6E:
-        case 0x7E:
-            ROR(opcode->mode);
-            break;
-
-            // RTI
-        case 0x40:
-            status = stack_pop();
-            status &= ~0x10;
-            program_counter = stack_pop_u16();
-            break;
-
-            // RTS
-        case 0x60:
-            program_counter = stack_pop_u16() + 1;
-            break;
-
-        case 0xE9:
-        case 0xE5:
-        case 0xF5:
-        case 0xED:
-        case 0xFD:
-        case 0xF9:
-        case 0xE1:
-        case 0xF1:
-            SBC(opcode->mode);
-            break;
-
-            // SEC
-        case 0x38:
-            set_carry_flag();
-            break;
-
-            // SED
-        case 0xF8:
-            status |= 0x08;
-            break;
-
-            // SEI
-        case 0x78:
-            status |= 0x04;
-            break;
-
-        case 0x85:
-        case 0x95:
-        case 0x8D:
-        case 0x9D:
-        case 0x99:
-        case 0x81:
-        case 0x91:
-            STA(opcode->mode);
-            break;
-
-        case 0x86:
-        case 0x96:
-        case 0x8E:
-            STX(opcode->mode);
-            break;
-
-        case 0x84:
-        case 0x94:
-        case 0x8C:
-            STY(opcode->mode);
-            break;
-
-        case 0xAA:
-            TAX();
-            break;
-
-        case 0xA8:
-            TAY();
-            break;
-
-        case 0xBA:
-            TSX();
-            break;
-
-        case 0x8A:
-            TXA();
-            break;
-
-        case 0x9A:
-            TXS();
-            break;
-
-        case 0x98:
-            TYA();
-            break;
-
-        default:
-            std::cerr << "Opcode non implment: 0x" << std::hex << static_cast<int>(code) << std::endl; // Ne devrait pas arriver
-            exit(1);
-        }
+const StopInfo& CPU::stop_info() const {
+    return last_stop;
+}
 
+void CPU::add_breakpoint(uint16_t addr, std::function<bool(const CPU&)> condition) {
+    if (!breakpoints) {
+        breakpoints = std::make_unique<std::array<uint64_t, 0x10000 / 64>>();
+        breakpoints->fill(0);
+        block_cache->set_breakpoints(breakpoints->data());
+    }
 
-        if (program_counter_state == program_counter) {
-            program_counter += (opcode->len - 1);
+    uint64_t& word = (*breakpoints)[addr >> 6];
+    uint64_t bit = 1ull << (addr & 0x3F);
+    if (!(word & bit)) {
+        word |= bit;
+        breakpoint_count++;
+        // Le bloc qui contient addr doit tre redcoup pour commencer  addr
+        block_cache->invalidate_page(Bus::mirror_down(addr) >> 8);
+    }
+    if (condition) {
+        breakpoint_conditions[addr] = std::move(condition);
+    }
+    else {
+        breakpoint_conditions.erase(addr);
+    }
+    debug_armed = true;
+}
+
+void CPU::remove_breakpoint(uint16_t addr) {
+    if (!breakpoints) {
+        return;
+    }
+    uint64_t& word = (*breakpoints)[addr >> 6];
+    uint64_t bit = 1ull << (addr & 0x3F);
+    if (word & bit) {
+        word &= ~bit;
+        breakpoint_count--;
+        block_cache->invalidate_page(Bus::mirror_down(addr) >> 8);
+    }
+    breakpoint_conditions.erase(addr);
+    debug_armed = breakpoint_count > 0 || bus.has_watchpoints() || watch_hit;
+}
+
+void CPU::clear_breakpoints() {
+    if (breakpoints) {
+        breakpoints.reset();
+        block_cache->set_breakpoints(nullptr);
+    }
+    breakpoint_conditions.clear();
+    breakpoint_count = 0;
+    debug_armed = bus.has_watchpoints() || watch_hit;
+}
+
+void CPU::add_watchpoint(uint16_t start, uint16_t end, MemoryAccess access) {
+    uint8_t kinds = 0;
+    if (access == MemoryAccess::Read || access == MemoryAccess::ReadWrite) {
+        kinds |= WATCH_READ;
+    }
+    if (access == MemoryAccess::Write || access == MemoryAccess::ReadWrite) {
+        kinds |= WATCH_WRITE;
+    }
+    bus.add_watchpoint(start, end, kinds);
+    debug_armed = true;
+}
+
+void CPU::clear_watchpoints() {
+    bus.clear_watchpoints();
+    watch_hit = false;
+    debug_armed = breakpoint_count > 0;
+}
+
+// Appel par le bus pendant l'instruction : l'arrt attend la fin de celle-ci, signale par l'interruption du bloc
+void CPU::on_watch(uint16_t addr, bool write) {
+    if (watch_hit) {
+        return;
+    }
+    watch_hit = true;
+    debug_armed = true;
+    watch_stop = { StopReason::Watchpoint, addr, write ? MemoryAccess::Write : MemoryAccess::Read };
+    block_cache->interrupt();
+}
+
+// Vrifi en dbut de bloc, seulement si debug_armed
+bool CPU::debug_stop(bool resuming) {
+    if (watch_hit) {
+        watch_hit = false;
+        debug_armed = breakpoint_count > 0 || bus.has_watchpoints();
+        last_stop = watch_stop;
+        return true;
+    }
+    if (resuming || breakpoint_count == 0 || !(((*breakpoints)[program_counter >> 6] >> (program_counter & 0x3F)) & 1)) {
+        return false;
+    }
+
+    auto condition = breakpoint_conditions.find(program_counter);
+    if (condition != breakpoint_conditions.end()) {
+        materialize_status();
+        if (!condition->second(*this)) {
+            return false;
         }
+    }
+    last_stop = { StopReason::Breakpoint, program_counter, MemoryAccess::None };
+    return true;
+}
+
+const DecodedBlock& CPU::fetch_block(uint16_t addr) {
+    return block_cache->fetch(addr);
+}
+
+int CPU::fast_forward_idle_loop(const DecodedBlock& block, int remaining_cycles) {
+    if (block.idle_loop == IdleLoop::None) {
+        poll_state.valid = false;
+        return 0;
+    }
 
-        cycles += opcode->cycles;
+    int iterations = 0;
+    if (block.idle_loop == IdleLoop::Countdown) {
+        poll_state.valid = false;
 
-        if (max_cycles > 0 && cycles >= max_cycles) {
-            break;
+        // On laisse la dernire itration  l'interprteur, qui sort de la boucle
+        uint8_t& counter = (block.counter_opcode == 0xCA || block.counter_opcode == 0xE8) ? register_x : register_y;
+        bool decrement = block.counter_opcode == 0xCA || block.counter_opcode == 0x88;
+        int total = decrement ? counter : (0x100 - counter) & 0xFF;
+        if (total == 0) {
+            total = 0x100;
+        }
+
+        // Le budget n'est vrifi qu'en fin de bloc : il doit rester au moins une itration  excuter
+        iterations = total - 1;
+        if (remaining_cycles >= 0) {
+            iterations = std::min(iterations, std::max(0, remaining_cycles - 1) / static_cast<int>(block.cycles));
+        }
+        if (iterations > 0) {
+            counter = decrement ? counter - iterations : counter + iterations;
+            update_zero_and_negative_flags(counter);
+        }
+    }
+    else {
+        // Sans criture mmoire, une itration qui laisse les registres inchangs se rptera  l'identique
+        bool fixed_point = poll_state.valid &&
+            poll_state.program_counter == program_counter &&
+            poll_state.register_a == register_a &&
+            poll_state.register_x == register_x &&
+            poll_state.register_y == register_y &&
+            poll_state.status == get_status() &&
+            poll_state.stack_pointer == stack_pointer;
+
+        if (fixed_point && remaining_cycles > 0) {
+            iterations = (remaining_cycles - 1) / static_cast<int>(block.cycles);
         }
+        poll_state = { true, program_counter, register_a, register_x, register_y, get_status(), stack_pointer };
+    }
+
+    int skipped = iterations * static_cast<int>(block.cycles);
+    cycles_skipped += skipped;
+    return skipped;
+}
+
+MemoryAccess CPU::memory_access(const DecodedInstruction& instruction, uint16_t& addr) const {
+    const OpCode& opcode = OPCODES_TABLE[instruction.code];
+    if (instruction.code == 0x20 || instruction.code == 0x4C) { // JSR et JMP n'accdent pas  leur oprande
+        return MemoryAccess::None;
+    }
+
+    switch (opcode.mode) {
+    case AddressingMode::ZeroPage:   addr = get_operand_address<AddressingMode::ZeroPage>(instruction.operand); break;
+    case AddressingMode::ZeroPage_X: addr = get_operand_address<AddressingMode::ZeroPage_X>(instruction.operand); break;
+    case AddressingMode::ZeroPage_Y: addr = get_operand_address<AddressingMode::ZeroPage_Y>(instruction.operand); break;
+    case AddressingMode::Absolute:   addr = get_operand_address<AddressingMode::Absolute>(instruction.operand); break;
+    case AddressingMode::Absolute_X: addr = get_operand_address<AddressingMode::Absolute_X>(instruction.operand); break;
+    case AddressingMode::Absolute_Y: addr = get_operand_address<AddressingMode::Absolute_Y>(instruction.operand); break;
+    case AddressingMode::Indirect_X: addr = get_operand_address<AddressingMode::Indirect_X>(instruction.operand); break;
+    case AddressingMode::Indirect_Y: addr = get_operand_address<AddressingMode::Indirect_Y>(instruction.operand); break;
+    default:
+        return MemoryAccess::None;
+    }
 
-        callback(*this);
+    // Opcode aaabbbcc : aaa et cc donnent l'opration, bbb le mode d'adressage
+    switch (instruction.code & 0xE3) {
+    case 0x81: // STA
+    case 0x82: // STX
+    case 0x80: // STY
+        return MemoryAccess::Write;
+    case 0x02: // ASL
+    case 0x22: // ROL
+    case 0x42: // LSR
+    case 0x62: // ROR
+    case 0xC2: // DEC
+    case 0xE2: // INC
+        return MemoryAccess::ReadWrite;
+    default:
+        return MemoryAccess::Read;
     }
 }
 
@@ -424,56 +298,116 @@ bool CPU::is_cpu_running() const {
     return is_running;
 }
 
+uint64_t CPU::skipped_cycles() const {
+    return cycles_skipped;
+}
+
+uint8_t CPU::get_status() const {
+#if LAZY_FLAGS
+    return (status & 0x3C) | (negative_result & 0x80) | overflow_bit | (zero_result == 0 ? 0x02 : 0) | carry_bit;
+#else
+    return status;
+#endif
+}
 
-uint16_t CPU::get_operand_address(AddressingMode mode) const {
-    switch (mode) {
-    case AddressingMode::Implied:
+void CPU::set_status(uint8_t value) {
+    status = value;
+    load_status_flags();
+}
+
+CpuState CPU::get_state() const {
+    return { register_a, register_x, register_y, get_status(), stack_pointer, program_counter, is_running };
+}
+
+void CPU::set_state(const CpuState& state) {
+    register_a = state.register_a;
+    register_x = state.register_x;
+    register_y = state.register_y;
+    stack_pointer = state.stack_pointer;
+    program_counter = state.program_counter;
+    set_status(state.status);
+    is_running = state.running;
+    poll_state.valid = false;
+    last_stop = { StopReason::Budget, 0, MemoryAccess::None };
+}
+
+uint64_t CPU::state_hash() const {
+    CpuState state = get_state();
+    uint64_t registers = static_cast<uint64_t>(state.register_a) | static_cast<uint64_t>(state.register_x) << 8 |
+        static_cast<uint64_t>(state.register_y) << 16 | static_cast<uint64_t>(state.status) << 24 |
+        static_cast<uint64_t>(state.stack_pointer) << 32 | static_cast<uint64_t>(state.program_counter) << 40 |
+        static_cast<uint64_t>(state.running) << 56;
+    // Bit 63 : hors du domaine des cls de la RAM
+    return bus.ram_hash() ^ Bus::mix_hash(registers | 1ull << 63);
+}
+
+template <AddressingMode mode>
+uint16_t CPU::get_operand_address(uint16_t operand) const {
+    if constexpr (mode == AddressingMode::Implied) {
         return 0;
-    case AddressingMode::Accumulator:
+    }
+    else if constexpr (mode == AddressingMode::Accumulator) {
         return 0;
-    case AddressingMode::Immediate:
+    }
+    else if constexpr (mode == AddressingMode::Immediate) {
         return program_counter;
-    case AddressingMode::ZeroPage:
-        return mem_read(program_counter);
-    case AddressingMode::ZeroPage_X:
-        return (mem_read(program_counter) + register_x) & 0xFF;
-    case AddressingMode::ZeroPage_Y:
-        return (mem_read(program_counter) + register_y) & 0xFF;
-    case AddressingMode::Relative: {
-        int8_t offset = mem_read(program_counter);
+    }
+    else if constexpr (mode == AddressingMode::ZeroPage) {
+        return operand & 0xFF;
+    }
+    else if constexpr (mode == AddressingMode::ZeroPage_X) {
+        return (operand + register_x) & 0xFF;
+    }
+    else if constexpr (mode == AddressingMode::ZeroPage_Y) {
+        return (operand + register_y) & 0xFF;
+    }
+    else if constexpr (mode == AddressingMode::Relative) {
+        int8_t offset = static_cast<int8_t>(operand);
         return program_counter + 1 + offset;
     }
-    case AddressingMode::Absolute:
-        return mem_read_u16(program_counter);
-    case AddressingMode::Absolute_X:
-        return mem_read_u16(program_counter) + register_x;
-    case AddressingMode::Absolute_Y:
-        return mem_read_u16(program_counter) + register_y;
-    case AddressingMode::Indirect: {
-        uint16_t addr = mem_read_u16(program_counter);
-        uint16_t lo = mem_read(addr);
-        uint16_t hi = mem_read((addr & 0xFF00) | ((addr + 1) & 0xFF));
+    else if constexpr (mode == AddressingMode::Absolute) {
+        return operand;
+    }
+    else if constexpr (mode == AddressingMode::Absolute_X) {
+        return operand + register_x;
+    }
+    else if constexpr (mode == AddressingMode::Absolute_Y) {
+        return operand + register_y;
+    }
+    else if constexpr (mode == AddressingMode::Indirect) {
+        uint16_t lo = mem_read(operand);
+        uint16_t hi = mem_read((operand & 0xFF00) | ((operand + 1) & 0xFF));
         return (hi << 8) | lo;
     }
-    case AddressingMode::Indirect_X: {
-        uint8_t ptr = mem_read(program_counter) + register_x;
+    else if constexpr (mode == AddressingMode::Indirect_X) {
+        uint8_t ptr = operand + register_x;
         uint16_t lo = mem_read(ptr & 0xFF);
         uint16_t hi = mem_read((ptr + 1) & 0xFF);
         return (hi << 8) | lo;
     }
-    case AddressingMode::Indirect_Y: {
-        uint8_t ptr = mem_read(program_counter);
-        uint16_t lo = mem_read(ptr & 0xFF);
+    else if constexpr (mode == AddressingMode::Indirect_Y) {
+        uint8_t ptr = operand & 0xFF;
+        uint16_t lo = mem_read(ptr);
         uint16_t hi = mem_read((ptr + 1) & 0xFF);
         return ((hi << 8) | lo) + register_y;
     }
-    default:
-        std::cerr << "Mode d'adressage non implment" << std::endl; // Non plus
-        return 0;
+}
+
+template <AddressingMode mode>
+uint8_t CPU::read_operand(uint16_t operand) const {
+    if constexpr (mode == AddressingMode::Immediate) {
+        return operand & 0xFF;
+    }
+    else {
+        return mem_read(get_operand_address<mode>(operand));
     }
 }
 
 void CPU::update_zero_and_negative_flags(uint8_t result) {
+#if LAZY_FLAGS
+    zero_result = result;
+    negative_result = result;
+#else
     if (result == 0) {
         status |= 0x02;
     }
@@ -487,15 +421,33 @@ void CPU::update_zero_and_negative_flags(uint8_t result) {
     else {
         status &= ~0x80;
     }
+#endif
+}
+
+void CPU::update_zero_flag(uint8_t result) {
+#if LAZY_FLAGS
+    zero_result = result;
+#else
+    if (result == 0) {
+        status |= 0x02;
+    }
+    else {
+        status &= ~0x02;
+    }
+#endif
 }
 
 void CPU::update_negative_flags(uint8_t result) {
+#if LAZY_FLAGS
+    negative_result = result;
+#else
     if (result & 0x80) {
         status |= 0x80;
     }
     else {
         status &= ~0x80;
     }
+#endif
 }
 
 void CPU::set_register_a(uint8_t value) {
@@ -504,25 +456,92 @@ void CPU::set_register_a(uint8_t value) {
 }
 
 void CPU::set_carry_flag() {
+#if LAZY_FLAGS
+    carry_bit = 0x01;
+#else
     status |= 0x01;
+#endif
 }
 
-void CPU::add_to_register_a(uint8_t data) {
-    uint16_t sum = register_a + data + (status & 0x01);
-    if (sum > 0xFF) {
-        set_carry_flag();
+void CPU::clear_carry_flag() {
+#if LAZY_FLAGS
+    carry_bit = 0;
+#else
+    status &= ~0x01;
+#endif
+}
+
+void CPU::set_overflow_flag(bool value) {
+#if LAZY_FLAGS
+    overflow_bit = value ? 0x40 : 0;
+#else
+    if (value) {
+        status |= 0x40;
     }
     else {
-        CLC();
+        status &= ~0x40;
     }
+#endif
+}
 
-    if (~(register_a ^ data) & (register_a ^ sum) & 0x80) {
-        status |= 0x40;
+bool CPU::carry_flag() const {
+#if LAZY_FLAGS
+    return carry_bit != 0;
+#else
+    return status & 0x01;
+#endif
+}
+
+bool CPU::zero_flag() const {
+#if LAZY_FLAGS
+    return zero_result == 0;
+#else
+    return status & 0x02;
+#endif
+}
+
+bool CPU::negative_flag() const {
+#if LAZY_FLAGS
+    return negative_result & 0x80;
+#else
+    return status & 0x80;
+#endif
+}
+
+bool CPU::overflow_flag() const {
+#if LAZY_FLAGS
+    return overflow_bit != 0;
+#else
+    return status & 0x40;
+#endif
+}
+
+void CPU::materialize_status() {
+#if LAZY_FLAGS
+    status = get_status();
+#endif
+}
+
+void CPU::load_status_flags() {
+#if LAZY_FLAGS
+    zero_result = (status & 0x02) ? 0 : 1;
+    negative_result = status & 0x80;
+    carry_bit = status & 0x01;
+    overflow_bit = status & 0x40;
+#endif
+}
+
+void CPU::add_to_register_a(uint8_t data) {
+    uint16_t sum = register_a + data + carry_flag();
+    if (sum > 0xFF) {
+        set_carry_flag();
     }
     else {
-        status &= ~0x40;
+        clear_carry_flag();
     }
 
+    set_overflow_flag(~(register_a ^ data) & (register_a ^ sum) & 0x80);
+
     register_a = sum & 0xFF;
     update_zero_and_negative_flags(register_a);
 }
@@ -551,37 +570,38 @@ uint16_t CPU::stack_pop_u16() {
 }
 
 
-void CPU::ADC(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::ADC(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     add_to_register_a(data);
 }
 
-void CPU::AND(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::AND(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     set_register_a(register_a & data);
 }
 
-void CPU::ASL(AddressingMode mode) {
-    if (mode == AddressingMode::Accumulator) {
+template <AddressingMode mode>
+void CPU::ASL(uint16_t operand) {
+    if constexpr (mode == AddressingMode::Accumulator) {
         if (register_a & 0x80) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         register_a <<= 1;
         update_zero_and_negative_flags(register_a);
     }
     else {
-        uint16_t addr = get_operand_address(mode);
+        uint16_t addr = get_operand_address<mode>(operand);
         uint8_t data = mem_read(addr);
         if (data & 0x80) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         data <<= 1;
         mem_write(addr, data);
@@ -590,9 +610,54 @@ void CPU::ASL(AddressingMode mode) {
 }
 
 
-void CPU::Branch(bool condition) {
+template <AddressingMode mode>
+void CPU::BCC(uint16_t operand) {
+    Branch(!carry_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BCS(uint16_t operand) {
+    Branch(carry_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BEQ(uint16_t operand) {
+    Branch(zero_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BMI(uint16_t operand) {
+    Branch(negative_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BNE(uint16_t operand) {
+    Branch(!zero_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BPL(uint16_t operand) {
+    Branch(!negative_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BRK(uint16_t operand) {
+    is_running = false;
+}
+
+template <AddressingMode mode>
+void CPU::BVC(uint16_t operand) {
+    Branch(!overflow_flag(), operand);
+}
+
+template <AddressingMode mode>
+void CPU::BVS(uint16_t operand) {
+    Branch(overflow_flag(), operand);
+}
+
+void CPU::Branch(bool condition, uint16_t operand) {
     if (condition) {
-        int8_t offset = static_cast<int8_t>(mem_read(program_counter));
+        int8_t offset = static_cast<int8_t>(operand);
         program_counter++;
         program_counter += offset;
     }
@@ -601,95 +666,116 @@ void CPU::Branch(bool condition) {
     }
 }
 
-void CPU::BIT(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
-    uint8_t result = register_a & data;
-    if (result == 0) {
-        status |= 0x02;
-    }
-    else {
-        status &= ~0x02;
-    }
-    status = (status & 0x3F) | (data & 0xC0);
+template <AddressingMode mode>
+void CPU::BIT(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
+    update_zero_flag(register_a & data);
+    update_negative_flags(data);
+    set_overflow_flag(data & 0x40);
 }
 
-void CPU::CLC() {
-    status &= ~0x01;
+template <AddressingMode mode>
+void CPU::CLC(uint16_t operand) {
+    clear_carry_flag();
 }
 
-void CPU::CMP(AddressingMode mode) {
-    compare(mode, register_a);
+template <AddressingMode mode>
+void CPU::CLD(uint16_t operand) {
+    status &= ~0x08;
 }
 
-void CPU::compare(AddressingMode mode, uint8_t compare_with) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::CLI(uint16_t operand) {
+    status &= ~0x04;
+}
+
+template <AddressingMode mode>
+void CPU::CLV(uint16_t operand) {
+    set_overflow_flag(false);
+}
+
+template <AddressingMode mode>
+void CPU::CMP(uint16_t operand) {
+    compare<mode>(operand, register_a);
+}
+
+template <AddressingMode mode>
+void CPU::compare(uint16_t operand, uint8_t compare_with) {
+    uint8_t data = read_operand<mode>(operand);
     uint8_t result = compare_with - data;
     if (compare_with >= data) {
         set_carry_flag();
     }
     else {
-        CLC();
+        clear_carry_flag();
     }
     update_zero_and_negative_flags(result);
 }
 
-void CPU::CPX(AddressingMode mode) {
-    compare(mode, register_x);
+template <AddressingMode mode>
+void CPU::CPX(uint16_t operand) {
+    compare<mode>(operand, register_x);
 }
 
-void CPU::CPY(AddressingMode mode) {
-    compare(mode, register_y);
+template <AddressingMode mode>
+void CPU::CPY(uint16_t operand) {
+    compare<mode>(operand, register_y);
 }
 
-void CPU::DEC(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
+template <AddressingMode mode>
+void CPU::DEC(uint16_t operand) {
+    uint16_t addr = get_operand_address<mode>(operand);
     uint8_t data = mem_read(addr);
     data--;
     mem_write(addr, data);
     update_zero_and_negative_flags(data);
 }
 
-void CPU::DEX() {
+template <AddressingMode mode>
+void CPU::DEX(uint16_t operand) {
     register_x--;
     update_zero_and_negative_flags(register_x);
 }
 
-void CPU::DEY() {
+template <AddressingMode mode>
+void CPU::DEY(uint16_t operand) {
     register_y--;
     update_zero_and_negative_flags(register_y);
 }
 
-void CPU::EOR(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::EOR(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     set_register_a(register_a ^ data);
 }
 
-void CPU::INC(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
+template <AddressingMode mode>
+void CPU::INC(uint16_t operand) {
+    uint16_t addr = get_operand_address<mode>(operand);
     uint8_t data = mem_read(addr);
     data++;
     mem_write(addr, data);
     update_zero_and_negative_flags(data);
 }
 
-void CPU::INX() {
+template <AddressingMode mode>
+void CPU::INX(uint16_t operand) {
     register_x++;
     update_zero_and_negative_flags(register_x);
 }
 
-void CPU::INY() {
+template <AddressingMode mode>
+void CPU::INY(uint16_t operand) {
     register_y++;
     update_zero_and_negative_flags(register_y);
 }
 
-void CPU::JMP(AddressingMode mode) {
+template <AddressingMode mode>
+void CPU::JMP(uint16_t operand) {
     uint16_t target;
 
-    if (mode == AddressingMode::Indirect) {
-        uint16_t addr = mem_read_u16(program_counter);
+    if constexpr (mode == AddressingMode::Indirect) {
+        uint16_t addr = operand;
 
         if ((addr & 0x00FF) == 0x00FF) {
             uint8_t lo = mem_read(addr);
@@ -700,8 +786,8 @@ void CPU::JMP(AddressingMode mode) {
             target = mem_read_u16(addr);
         }
     }
-    else if (mode == AddressingMode::Absolute) {
-        target = mem_read_u16(program_counter);
+    else if constexpr (mode == AddressingMode::Absolute) {
+        target = operand;
     }
     else {
         std::cerr << "Mode d'adressage non support pour JMP" << std::endl; // Non plus
@@ -711,51 +797,53 @@ void CPU::JMP(AddressingMode mode) {
     program_counter = target;
 }
 
-void CPU::JSR(AddressingMode mode) {
+template <AddressingMode mode>
+void CPU::JSR(uint16_t operand) {
     stack_push_u16(program_counter + 1);
-    uint16_t target = get_operand_address(mode);
+    uint16_t target = get_operand_address<mode>(operand);
     program_counter = target;
 }
 
-void CPU::LDA(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::LDA(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     set_register_a(data);
 }
 
-void CPU::LDX(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::LDX(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     register_x = data;
     update_zero_and_negative_flags(register_x);
 }
 
-void CPU::LDY(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::LDY(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     register_y = data;
     update_zero_and_negative_flags(register_y);
 }
 
-void CPU::LSR(AddressingMode mode) {
-    if (mode == AddressingMode::Accumulator) {
+template <AddressingMode mode>
+void CPU::LSR(uint16_t operand) {
+    if constexpr (mode == AddressingMode::Accumulator) {
         if (register_a & 0x01) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         register_a >>= 1;
         update_zero_and_negative_flags(register_a);
     }
     else {
-        uint16_t addr = get_operand_address(mode);
+        uint16_t addr = get_operand_address<mode>(operand);
         uint8_t data = mem_read(addr);
         if (data & 0x01) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         data >>= 1;
         mem_write(addr, data);
@@ -763,47 +851,59 @@ void CPU::LSR(AddressingMode mode) {
     }
 }
 
-void CPU::ORA(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::NOP(uint16_t operand) {
+}
+
+template <AddressingMode mode>
+void CPU::ORA(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     set_register_a(register_a | data);
 }
 
-void CPU::PHP() {
-    stack_push(status | 0x10);
+template <AddressingMode mode>
+void CPU::PHA(uint16_t operand) {
+    stack_push(register_a);
+}
+
+template <AddressingMode mode>
+void CPU::PHP(uint16_t operand) {
+    stack_push(get_status() | 0x10);
 }
 
-void CPU::PLA() {
+template <AddressingMode mode>
+void CPU::PLA(uint16_t operand) {
     register_a = stack_pop();
     update_zero_and_negative_flags(register_a);
 }
 
-void CPU::PLP() {
-    status = stack_pop();
-    status &= ~0x10;
+template <AddressingMode mode>
+void CPU::PLP(uint16_t operand) {
+    set_status(stack_pop() & ~0x10);
 }
 
-void CPU::ROL(AddressingMode mode) {
-    uint8_t carry = (status & 0x01);
+template <AddressingMode mode>
+void CPU::ROL(uint16_t operand) {
+    uint8_t carry = carry_flag();
 
-    if (mode == AddressingMode::Accumulator) {
+    if constexpr (mode == AddressingMode::Accumulator) {
         if (register_a & 0x80) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         register_a = (register_a << 1) | carry;
         update_zero_and_negative_flags(register_a);
     }
     else {
-        uint16_t addr = get_operand_address(mode);
+        uint16_t addr = get_operand_address<mode>(operand);
         uint8_t data = mem_read(addr);
         if (data & 0x80) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         data = (data << 1) | carry;
         mem_write(addr, data);
@@ -811,27 +911,28 @@ void CPU::ROL(AddressingMode mode) {
     }
 }
 
-void CPU::ROR(AddressingMode mode) {
-    uint8_t carry = (status & 0x01) << 7;
+template <AddressingMode mode>
+void CPU::ROR(uint16_t operand) {
+    uint8_t carry = carry_flag() << 7;
 
-    if (mode == AddressingMode::Accumulator) {
+    if constexpr (mode == AddressingMode::Accumulator) {
         if (register_a & 0x01) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         register_a = (register_a >> 1) | carry;
         update_zero_and_negative_flags(register_a);
     }
     else {
-        uint16_t addr = get_operand_address(mode);
+        uint16_t addr = get_operand_address<mode>(operand);
         uint8_t data = mem_read(addr);
         if (data & 0x01) {
             set_carry_flag();
         }
         else {
-            CLC();
+            clear_carry_flag();
         }
         data = (data >> 1) | carry;
         mem_write(addr, data);
@@ -839,53 +940,101 @@ void CPU::ROR(AddressingMode mode) {
     }
 }
 
-void CPU::SBC(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
-    uint8_t data = mem_read(addr);
+template <AddressingMode mode>
+void CPU::RTI(uint16_t operand) {
+    set_status(stack_pop() & ~0x10);
+    program_counter = stack_pop_u16();
+}
+
+template <AddressingMode mode>
+void CPU::RTS(uint16_t operand) {
+    program_counter = stack_pop_u16() + 1;
+}
+
+template <AddressingMode mode>
+void CPU::SBC(uint16_t operand) {
+    uint8_t data = read_operand<mode>(operand);
     add_to_register_a(~data);
 }
 
-void CPU::STA(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
+template <AddressingMode mode>
+void CPU::SEC(uint16_t operand) {
+    set_carry_flag();
+}
+
+template <AddressingMode mode>
+void CPU::SED(uint16_t operand) {
+    status |= 0x08;
+}
+
+template <AddressingMode mode>
+void CPU::SEI(uint16_t operand) {
+    status |= 0x04;
+}
+
+template <AddressingMode mode>
+void CPU::STA(uint16_t operand) {
+    uint16_t addr = get_operand_address<mode>(operand);
     mem_write(addr, register_a);
 }
 
-void CPU::STX(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
+template <AddressingMode mode>
+void CPU::STX(uint16_t operand) {
+    uint16_t addr = get_operand_address<mode>(operand);
     mem_write(addr, register_x);
 }
 
-void CPU::STY(AddressingMode mode) {
-    uint16_t addr = get_operand_address(mode);
+template <AddressingMode mode>
+void CPU::STY(uint16_t operand) {
+    uint16_t addr = get_operand_address<mode>(operand);
     mem_write(addr, register_y);
 }
 
-void CPU::TAX() {
+template <AddressingMode mode>
+void CPU::TAX(uint16_t operand) {
     register_x = register_a;
     update_zero_and_negative_flags(register_x);
 }
 
-void CPU::TAY() {
+template <AddressingMode mode>
+void CPU::TAY(uint16_t operand) {
     register_y = register_a;
     update_zero_and_negative_flags(register_y);
 }
 
-void CPU::TSX() {
+template <AddressingMode mode>
+void CPU::TSX(uint16_t operand) {
     register_x = stack_pointer;
     update_zero_and_negative_flags(register_x);
 }
 
-void CPU::TXA() {
+template <AddressingMode mode>
+void CPU::TXA(uint16_t operand) {
     register_a = register_x;
     update_zero_and_negative_flags(register_a);
 }
 
-void CPU::TXS() {
+template <AddressingMode mode>
+void CPU::TXS(uint16_t operand) {
     stack_pointer = register_x;
 }
 
-void CPU::TYA() {
+template <AddressingMode mode>
+void CPU::TYA(uint16_t operand) {
     register_a = register_y;
     update_zero_and_negative_flags(register_a);
 }
 
+template <AddressingMode mode>
+// Arrt silencieux : l'appelant le signale d'aprs stop_info(), et relit l'opcode par Bus::peek
+void CPU::TRAP(uint16_t) {
+    last_stop = { StopReason::IllegalOpcode, static_cast<uint16_t>(program_counter - 1), MemoryAccess::None };
+    is_running = false;
+}
+
+// Une instanciation par opcode document, rfrence par OPCODES_TABLE
+#define OPCODE(code, name, len, cycles, mode) template void CPU::name<AddressingMode::mode>(uint16_t);
+#include "OpCodes.inc"
+#undef OPCODE
+
+template void CPU::TRAP<AddressingMode::Implied>(uint16_t);
\ No newline at end of file
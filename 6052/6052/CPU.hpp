@@ -3,13 +3,24 @@
 
 #include "Bus.hpp"
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+// N, Z, C et V valus seulement quand P est lu (1) ou mis  jour  chaque instruction (0)
+#ifndef LAZY_FLAGS
+#define LAZY_FLAGS 1
+#endif
+
+// Adresse de chargement des programmes, mise dans le vecteur de reset
+#define PROGRAM_START 0x0600
 
-enum class AddressingMode {
+enum class AddressingMode : uint8_t {
     Implied, // Aussi appel "Implicit"
     Accumulator,
     Immediate,
@@ -25,19 +36,113 @@ enum class AddressingMode {
     Indirect_Y, // Aussi appel "Indirect Indexed"
 };
 
+// Points d'observation de run_with_callback, combinables
+enum HookMask : uint8_t {
+    HOOK_NONE        = 0x00,
+    HOOK_INSTRUCTION = 0x01, // on_instruction(CPU&) aprs chaque instruction
+    HOOK_BRANCH      = 0x02, // on_branch(CPU&, adresse du branchement, pris ?) aprs chaque branchement conditionnel
+    HOOK_MEMORY      = 0x04, // on_memory_access(CPU&, adresse, accs) aprs chaque accs  l'oprande en mmoire
+    HOOK_EXECUTE     = 0x08, // on_execute(const CPU&, const DecodedInstruction&) avant chaque instruction, registres inchangs
+};
+
+enum class MemoryAccess : uint8_t {
+    None,
+    Read,
+    Write,
+    ReadWrite, // INC, DEC, ASL, LSR, ROL et ROR sur la mmoire
+};
+
+// Raison pour laquelle run et run_with_callback ont rendu la main
+enum class StopReason : uint8_t {
+    Budget,        // max_cycles atteint
+    Halted,        // BRK
+    IllegalOpcode, // opcode non document
+    Breakpoint,    // avant l'instruction du point d'arrt, qui sera excute par le run suivant
+    Watchpoint,    // aprs l'instruction qui a accd  l'octet surveill
+};
+
+struct StopInfo {
+    StopReason reason;
+    uint16_t address;    // instruction, ou octet surveill pour StopReason::Watchpoint
+    MemoryAccess access; // Read ou Write pour StopReason::Watchpoint
+};
+
+// Callback sans aucun hook : c'est celui de run(), le seul qui autorise le saut des boucles d'attente
+struct NoHook {
+    static constexpr uint8_t hook_mask = HOOK_NONE;
+};
+
+// Un callback est soit un appelable void(CPU&) excut aprs chaque instruction,
+// soit une structure qui dclare hook_mask et les mthodes on_* correspondantes
+template <typename Callback, typename = void>
+struct HookTraits {
+    static constexpr uint8_t mask = HOOK_INSTRUCTION;
+    static constexpr bool callable = true;
+};
+
+template <typename Callback>
+struct HookTraits<Callback, std::void_t<decltype(Callback::hook_mask)>> {
+    static constexpr uint8_t mask = Callback::hook_mask;
+    static constexpr bool callable = false;
+};
+
+// Registres et tat d'excution, tels que sauvegards par SaveState
+struct CpuState {
+    uint8_t register_a;
+    uint8_t register_x;
+    uint8_t register_y;
+    uint8_t status;
+    uint8_t stack_pointer;
+    uint16_t program_counter;
+    bool running;
+};
+
+class BlockCache;
+struct DecodedBlock;
+struct DecodedInstruction;
+struct OpCode;
+
 class CPU {
 public:
     explicit CPU(Bus& bus_ref);
+    ~CPU();
 
     void reset();
     void load(const std::vector<uint8_t>& program);
+    // Programme charg par de nombreuses machines : ses pages sont partages jusqu' leur premire criture
+    void load(const ProgramImage& image);
     void load_and_run(const std::vector<uint8_t>& program);
-    void run(int max_cycles = -1);
-    void run_with_callback(std::function<void(CPU&)> callback, int max_cycles = -1);
+    // Renvoient le nombre de cycles couls, boucles d'attente sautes comprises
+    int run(int max_cycles = -1);
+    template <typename Callback> int run_with_callback(Callback&& callback, int max_cycles = -1);
+    // Une seule instruction, sans cache de blocs, point d'arrt ni saut de boucle d'attente ; renvoie ses cycles, 0 si arrt
+    int step();
+    // Pourquoi le dernier run s'est arrt
+    const StopInfo& stop_info() const;
+
+    // Sans point d'arrt ni de surveillance arm, run ne paie qu'un test par bloc.
+    // Une condition, value registres  jour, rend le point d'arrt conditionnel.
+    void add_breakpoint(uint16_t addr, std::function<bool(const CPU&)> condition = nullptr);
+    void remove_breakpoint(uint16_t addr);
+    void clear_breakpoints();
+    // access : Read, Write ou ReadWrite ; seules les pages surveilles quittent le chemin rapide du bus
+    void add_watchpoint(uint16_t start, uint16_t end, MemoryAccess access);
+    void clear_watchpoints();
 
     uint8_t mem_read(uint16_t addr) const;
     void mem_write(uint16_t addr, uint8_t data);
     bool is_cpu_running() const;
+    uint64_t skipped_cycles() const;
+
+    // status n'est  jour qu'entre deux excutions et dans le callback ; ces accesseurs le sont toujours
+    uint8_t get_status() const;
+    void set_status(uint8_t value);
+
+    CpuState get_state() const;
+    void set_state(const CpuState& state);
+    // Empreinte de l'tat (registres, marche et RAM) en O(1), aprs bus.enable_ram_hash() : deux tats gaux ont la
+    // mme empreinte. Les registres, quelques octets, sont mlangs  la lecture plutt qu' chaque instruction
+    uint64_t state_hash() const;
 
     uint8_t register_a;
     uint8_t register_x;
@@ -48,65 +153,265 @@ public:
 
 private:
     Bus& bus;
+    std::unique_ptr<BlockCache> block_cache;
+    const uint32_t* block_generation;
 
     bool is_running;
 
+    // Registres  l'entre de la dernire boucle d'attente IdleLoop::Poll excute
+    struct PollState {
+        bool valid;
+        uint16_t program_counter;
+        uint8_t register_a;
+        uint8_t register_x;
+        uint8_t register_y;
+        uint8_t status;
+        uint8_t stack_pointer;
+    };
+    PollState poll_state;
+    uint64_t cycles_skipped;
+
+    // Bitmap de 64 Kbit allou au premier point d'arrt, partag avec le cache de blocs
+    std::unique_ptr<std::array<uint64_t, 0x10000 / 64>> breakpoints;
+    std::unordered_map<uint16_t, std::function<bool(const CPU&)>> breakpoint_conditions;
+    size_t breakpoint_count;
+    bool debug_armed; // un point d'arrt ou de surveillance est arm, ou un accs surveill attend
+    bool watch_hit;
+    StopInfo watch_stop; // premier accs surveill de l'instruction en cours
+    StopInfo last_stop;
+
+#if LAZY_FLAGS
+    // Derniers rsultats dont drivent les drapeaux : Z = (zero_result == 0), N = bit 7 de negative_result
+    uint8_t zero_result;
+    uint8_t negative_result;
+    uint8_t carry_bit;     // 0 ou 0x01
+    uint8_t overflow_bit;  // 0 ou 0x40
+#endif
+
+    const DecodedBlock& fetch_block(uint16_t addr);
+    int fast_forward_idle_loop(const DecodedBlock& block, int remaining_cycles);
+    bool debug_stop(bool resuming);
+    void on_watch(uint16_t addr, bool write);
+    MemoryAccess memory_access(const DecodedInstruction& instruction, uint16_t& addr) const;
+
     uint16_t mem_read_u16(uint16_t addr) const;
     void mem_write_u16(uint16_t addr, uint16_t data);
 
-    uint16_t get_operand_address(AddressingMode mode) const;
+    template <AddressingMode mode> uint16_t get_operand_address(uint16_t operand) const;
+    template <AddressingMode mode> uint8_t read_operand(uint16_t operand) const;
 
     void update_zero_and_negative_flags(uint8_t result);
+    void update_zero_flag(uint8_t result);
     void update_negative_flags(uint8_t result);
     void set_register_a(uint8_t value);
     void set_carry_flag();
+    void clear_carry_flag();
+    void set_overflow_flag(bool value);
+    bool carry_flag() const;
+    bool zero_flag() const;
+    bool negative_flag() const;
+    bool overflow_flag() const;
+    void materialize_status();
+    void load_status_flags();
     void add_to_register_a(uint8_t data);
-    void compare(AddressingMode mode, uint8_t compare_with);
-
-
-    void ADC(AddressingMode mode);
-    void AND(AddressingMode mode);
-    void ASL(AddressingMode mode);
-    void Branch(bool condition);
-    void BIT(AddressingMode mode);
-    void CLC();
-    void CMP(AddressingMode mode);
-    void CPX(AddressingMode mode);
-    void CPY(AddressingMode mode);
-    void DEC(AddressingMode mode);
-    void DEX();
-    void DEY();
-    void EOR(AddressingMode mode);
-    void INC(AddressingMode mode);
-    void INX();
-    void INY();
-    void JMP(AddressingMode mode);
-    void JSR(AddressingMode mode);
-    void LDA(AddressingMode mode);
-    void LDX(AddressingMode mode);
-    void LDY(AddressingMode mode);
-    void LSR(AddressingMode mode);
-    void ORA(AddressingMode mode);
-    void PHP();
-    void PLA();
-    void PLP();
-    void ROL(AddressingMode mode);
-    void ROR(AddressingMode mode);
-    void SBC(AddressingMode mode);
-    void STA(AddressingMode mode);
-    void STX(AddressingMode mode);
-    void STY(AddressingMode mode);
-    void TAX();
-    void TAY();
-    void TSX();
-    void TXA();
-    void TXS();
-    void TYA();
-    
+    template <AddressingMode mode> void compare(uint16_t operand, uint8_t compare_with);
+    void Branch(bool condition, uint16_t operand);
+
+
+    template <AddressingMode mode> void ADC(uint16_t operand);
+    template <AddressingMode mode> void AND(uint16_t operand);
+    template <AddressingMode mode> void ASL(uint16_t operand);
+    template <AddressingMode mode> void BCC(uint16_t operand);
+    template <AddressingMode mode> void BCS(uint16_t operand);
+    template <AddressingMode mode> void BEQ(uint16_t operand);
+    template <AddressingMode mode> void BIT(uint16_t operand);
+    template <AddressingMode mode> void BMI(uint16_t operand);
+    template <AddressingMode mode> void BNE(uint16_t operand);
+    template <AddressingMode mode> void BPL(uint16_t operand);
+    template <AddressingMode mode> void BRK(uint16_t operand);
+    template <AddressingMode mode> void BVC(uint16_t operand);
+    template <AddressingMode mode> void BVS(uint16_t operand);
+    template <AddressingMode mode> void CLC(uint16_t operand);
+    template <AddressingMode mode> void CLD(uint16_t operand);
+    template <AddressingMode mode> void CLI(uint16_t operand);
+    template <AddressingMode mode> void CLV(uint16_t operand);
+    template <AddressingMode mode> void CMP(uint16_t operand);
+    template <AddressingMode mode> void CPX(uint16_t operand);
+    template <AddressingMode mode> void CPY(uint16_t operand);
+    template <AddressingMode mode> void DEC(uint16_t operand);
+    template <AddressingMode mode> void DEX(uint16_t operand);
+    template <AddressingMode mode> void DEY(uint16_t operand);
+    template <AddressingMode mode> void EOR(uint16_t operand);
+    template <AddressingMode mode> void INC(uint16_t operand);
+    template <AddressingMode mode> void INX(uint16_t operand);
+    template <AddressingMode mode> void INY(uint16_t operand);
+    template <AddressingMode mode> void JMP(uint16_t operand);
+    template <AddressingMode mode> void JSR(uint16_t operand);
+    template <AddressingMode mode> void LDA(uint16_t operand);
+    template <AddressingMode mode> void LDX(uint16_t operand);
+    template <AddressingMode mode> void LDY(uint16_t operand);
+    template <AddressingMode mode> void LSR(uint16_t operand);
+    template <AddressingMode mode> void NOP(uint16_t operand);
+    template <AddressingMode mode> void ORA(uint16_t operand);
+    template <AddressingMode mode> void PHA(uint16_t operand);
+    template <AddressingMode mode> void PHP(uint16_t operand);
+    template <AddressingMode mode> void PLA(uint16_t operand);
+    template <AddressingMode mode> void PLP(uint16_t operand);
+    template <AddressingMode mode> void ROL(uint16_t operand);
+    template <AddressingMode mode> void ROR(uint16_t operand);
+    template <AddressingMode mode> void RTI(uint16_t operand);
+    template <AddressingMode mode> void RTS(uint16_t operand);
+    template <AddressingMode mode> void SBC(uint16_t operand);
+    template <AddressingMode mode> void SEC(uint16_t operand);
+    template <AddressingMode mode> void SED(uint16_t operand);
+    template <AddressingMode mode> void SEI(uint16_t operand);
+    template <AddressingMode mode> void STA(uint16_t operand);
+    template <AddressingMode mode> void STX(uint16_t operand);
+    template <AddressingMode mode> void STY(uint16_t operand);
+    template <AddressingMode mode> void TAX(uint16_t operand);
+    template <AddressingMode mode> void TAY(uint16_t operand);
+    template <AddressingMode mode> void TSX(uint16_t operand);
+    template <AddressingMode mode> void TXA(uint16_t operand);
+    template <AddressingMode mode> void TXS(uint16_t operand);
+    template <AddressingMode mode> void TYA(uint16_t operand);
+    template <AddressingMode mode> void TRAP(uint16_t operand); // Opcode non document
+
     uint8_t stack_pop();
     uint16_t stack_pop_u16();
     void stack_push(uint8_t data);
     void stack_push_u16(uint16_t data);
+
+    friend class BlockCache;
+    friend constexpr std::array<OpCode, 256> make_opcodes_table();
+};
+
+using OpHandler = void (CPU::*)(uint16_t operand);
+
+struct DecodedInstruction {
+    OpHandler handler;
+    uint16_t address;
+    uint16_t operand;
+    uint8_t code;
+    uint8_t len;
+    uint8_t cycles;
+};
+
+enum class IdleLoop : uint8_t {
+    None,
+    Countdown, // NOP et un seul DEX/DEY/INX/INY, puis BNE vers le dbut du bloc
+    Poll,      // Boucle sur elle-mme sans criture mmoire ni lecture de priphrique : point fixe ds que les registres ne changent plus
+};
+
+// Suite d'instructions sans saut, termine par un branchement, un saut, une fin de page ou MAX_BLOCK_LENGTH
+struct DecodedBlock {
+    std::vector<DecodedInstruction> instructions;
+    uint32_t cycles;
+    IdleLoop idle_loop;
+    uint8_t counter_opcode; // DEX, DEY, INX ou INY pour IdleLoop::Countdown
 };
 
+template <typename Callback>
+int CPU::run_with_callback(Callback&& callback, int max_cycles) {
+    using Hooks = HookTraits<std::decay_t<Callback>>;
+    int cycles = 0;
+    poll_state.valid = false;
+    load_status_flags();
+
+    // Repartir d'un point d'arrt excute son instruction au lieu de s'y arrter  nouveau
+    bool resuming = last_stop.reason == StopReason::Breakpoint && last_stop.address == program_counter;
+    last_stop = { StopReason::Budget, 0, MemoryAccess::None };
+
+    while (true) {
+        if (debug_armed && debug_stop(resuming)) {
+            break;
+        }
+        resuming = false;
+
+        const DecodedBlock& block = fetch_block(program_counter);
+        // Sans hook, personne n'observe les itrations des boucles d'attente : elles peuvent tre sautes
+        if constexpr (Hooks::mask == HOOK_NONE) {
+            if (!debug_armed) {
+                cycles += fast_forward_idle_loop(block, max_cycles > 0 ? max_cycles - cycles : -1);
+            }
+        }
+
+        const DecodedInstruction* instructions = block.instructions.data();
+        size_t count = block.instructions.size();
+        uint32_t generation = *block_generation;
+
+        for (size_t i = 0; i < count; ++i) {
+            const DecodedInstruction instruction = instructions[i];
+            uint16_t program_counter_state = instruction.address + 1;
+
+            // L'adresse effective dpend des registres avant l'instruction
+            uint16_t access_address = 0;
+            MemoryAccess access = MemoryAccess::None;
+            if constexpr ((Hooks::mask & HOOK_MEMORY) != 0) {
+                access = memory_access(instruction, access_address);
+            }
+
+            if constexpr ((Hooks::mask & HOOK_EXECUTE) != 0) {
+                materialize_status();
+                callback.on_execute(*this, instruction);
+            }
+
+            program_counter = program_counter_state;
+            (this->*instruction.handler)(instruction.operand);
+            if (!is_running) {
+                if (last_stop.reason == StopReason::Budget) {
+                    last_stop = { StopReason::Halted, instruction.address, MemoryAccess::None };
+                }
+                materialize_status();
+                return cycles + instruction.cycles;
+            }
+
+            if (program_counter_state == program_counter) {
+                program_counter += (instruction.len - 1);
+            }
+
+            cycles += instruction.cycles;
+
+            if constexpr (Hooks::mask != HOOK_NONE) {
+                materialize_status();
+                if constexpr ((Hooks::mask & HOOK_MEMORY) != 0) {
+                    if (access != MemoryAccess::None) {
+                        callback.on_memory_access(*this, access_address, access);
+                    }
+                }
+                if constexpr ((Hooks::mask & HOOK_BRANCH) != 0) {
+                    // Les huit branchements conditionnels sont les opcodes xxx10000
+                    if ((instruction.code & 0x1F) == 0x10) {
+                        callback.on_branch(*this, instruction.address, program_counter != instruction.address + instruction.len);
+                    }
+                }
+                if constexpr ((Hooks::mask & HOOK_INSTRUCTION) != 0) {
+                    if constexpr (Hooks::callable) {
+                        callback(*this);
+                    }
+                    else {
+                        callback.on_instruction(*this);
+                    }
+                }
+                load_status_flags();
+            }
+
+            // Le bloc a t invalid par une criture dans son propre code, interrompu par un accs surveill,
+            // ou un hook a dplac le PC
+            if (*block_generation != generation || program_counter != instruction.address + instruction.len) {
+                break;
+            }
+        }
+
+        if (max_cycles > 0 && cycles >= max_cycles) {
+            // Un arrt sur le dernier bloc l'emporte sur le budget
+            if (debug_armed) {
+                debug_stop(false);
+            }
+            break;
+        }
+    }
+    materialize_status();
+    return cycles;
+}
+
 #endif
@@ -1,5 +1,24 @@
 #include "Color.hpp"
 
+#include <array>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PALETTE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define PALETTE_X86 0
+#endif
+
 Color color(uint8_t byte) {
     switch (byte) {
     case 0x0: return Color{ 0, 0, 0, 255 };          // Noir
@@ -21,3 +40,184 @@ Color color(uint8_t byte) {
     default: return Color{ 0, 0, 0, 255 };           // Par dfaut, Noir
     }
 }
+
+// Couleurs RGBA des 16 indices, canal par canal pour les tables de pshufb
+struct PaletteTables {
+    alignas(16) uint8_t r[16];
+    alignas(16) uint8_t g[16];
+    alignas(16) uint8_t b[16];
+    std::array<uint32_t, 0x100> rgba; // Les 256 valeurs d'octet, pour le chemin scalaire
+};
+
+static PaletteTables make_palette_tables() {
+    PaletteTables tables;
+    for (int i = 0; i < 0x100; ++i) {
+        Color col = color(static_cast<uint8_t>(i));
+        if (i < 16) {
+            tables.r[i] = col.r;
+            tables.g[i] = col.g;
+            tables.b[i] = col.b;
+        }
+        std::memcpy(&tables.rgba[i], &col, sizeof(uint32_t));
+    }
+    return tables;
+}
+
+static const PaletteTables& palette_tables() {
+    static const PaletteTables tables = make_palette_tables();
+    return tables;
+}
+
+static void expand_row_scalar(const uint8_t* indices, uint8_t* dest, int count) {
+    const std::array<uint32_t, 0x100>& rgba = palette_tables().rgba;
+    for (int i = 0; i < count; ++i) {
+        std::memcpy(dest + i * 4, &rgba[indices[i]], sizeof(uint32_t));
+    }
+}
+
+#if PALETTE_X86
+TARGET_SSSE3 static void expand_row_ssse3(const uint8_t* indices, uint8_t* dest, int count) {
+    const PaletteTables& tables = palette_tables();
+    const __m128i table_r = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.r));
+    const __m128i table_g = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.g));
+    const __m128i table_b = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.b));
+    const __m128i high = _mm_set1_epi8(static_cast<char>(0xF0));
+    const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+        // Comme color(), un octet hors palette donne du noir opaque
+        __m128i valid = _mm_cmpeq_epi8(_mm_and_si128(index, high), _mm_setzero_si128());
+        __m128i r = _mm_and_si128(_mm_shuffle_epi8(table_r, index), valid);
+        __m128i g = _mm_and_si128(_mm_shuffle_epi8(table_g, index), valid);
+        __m128i b = _mm_and_si128(_mm_shuffle_epi8(table_b, index), valid);
+
+        __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+        __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+        __m128i ba_lo = _mm_unpacklo_epi8(b, alpha);
+        __m128i ba_hi = _mm_unpackhi_epi8(b, alpha);
+
+        __m128i* out = reinterpret_cast<__m128i*>(dest + i * 4);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(rg_lo, ba_lo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg_lo, ba_lo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rg_hi, ba_hi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rg_hi, ba_hi));
+    }
+    expand_row_scalar(indices + i, dest + i * 4, count - i);
+}
+
+TARGET_AVX2 static void expand_row_avx2(const uint8_t* indices, uint8_t* dest, int count) {
+    const PaletteTables& tables = palette_tables();
+    const __m256i table_r = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.r)));
+    const __m256i table_g = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.g)));
+    const __m256i table_b = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.b)));
+    const __m256i high = _mm256_set1_epi8(static_cast<char>(0xF0));
+    const __m256i alpha = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+        __m256i valid = _mm256_cmpeq_epi8(_mm256_and_si256(index, high), _mm256_setzero_si256());
+        __m256i r = _mm256_and_si256(_mm256_shuffle_epi8(table_r, index), valid);
+        __m256i g = _mm256_and_si256(_mm256_shuffle_epi8(table_g, index), valid);
+        __m256i b = _mm256_and_si256(_mm256_shuffle_epi8(table_b, index), valid);
+
+        // Les entrelacements travaillent par moitis de 128 bits : pixels 0-15  gauche, 16-31  droite
+        __m256i rg_lo = _mm256_unpacklo_epi8(r, g);
+        __m256i rg_hi = _mm256_unpackhi_epi8(r, g);
+        __m256i ba_lo = _mm256_unpacklo_epi8(b, alpha);
+        __m256i ba_hi = _mm256_unpackhi_epi8(b, alpha);
+        __m256i rgba_0 = _mm256_unpacklo_epi16(rg_lo, ba_lo); // 0-3 et 16-19
+        __m256i rgba_1 = _mm256_unpackhi_epi16(rg_lo, ba_lo); // 4-7 et 20-23
+        __m256i rgba_2 = _mm256_unpacklo_epi16(rg_hi, ba_hi); // 8-11 et 24-27
+        __m256i rgba_3 = _mm256_unpackhi_epi16(rg_hi, ba_hi); // 12-15 et 28-31
+
+        __m256i* out = reinterpret_cast<__m256i*>(dest + i * 4);
+        _mm256_storeu_si256(out, _mm256_permute2x128_si256(rgba_0, rgba_1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(rgba_2, rgba_3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(rgba_0, rgba_1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(rgba_2, rgba_3, 0x31));
+    }
+    expand_row_ssse3(indices + i, dest + i * 4, count - i);
+}
+
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned registers[4]) {
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        registers[i] = static_cast<unsigned>(values[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// Registres YMM sauvegards par le systme
+static bool os_saves_ymm() {
+#if defined(_MSC_VER)
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    unsigned lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (lo & 0x6) == 0x6;
+#endif
+}
+
+static PaletteKernel detect_palette_kernel() {
+    unsigned registers[4];
+    cpuid(0, 0, registers);
+    unsigned max_leaf = registers[0];
+
+    cpuid(1, 0, registers);
+    bool ssse3 = registers[2] & (1u << 9);
+    bool osxsave = registers[2] & (1u << 27);
+    bool avx = registers[2] & (1u << 28);
+
+    bool avx2 = false;
+    if (max_leaf >= 7 && osxsave && avx && os_saves_ymm()) {
+        cpuid(7, 0, registers);
+        avx2 = registers[1] & (1u << 5);
+    }
+
+    if (avx2) {
+        return PaletteKernel::Avx2;
+    }
+    return ssse3 ? PaletteKernel::Ssse3 : PaletteKernel::Scalar;
+}
+#else
+static PaletteKernel detect_palette_kernel() {
+    return PaletteKernel::Scalar;
+}
+#endif
+
+PaletteKernel palette_kernel() {
+    static const PaletteKernel kernel = detect_palette_kernel();
+    return kernel;
+}
+
+void expand_palette(const uint8_t* indices, int width, int height, uint8_t* dest, size_t dest_pitch) {
+    expand_palette(indices, width, height, dest, dest_pitch, palette_kernel());
+}
+
+void expand_palette(const uint8_t* indices, int width, int height, uint8_t* dest, size_t dest_pitch, PaletteKernel kernel) {
+    // Un noyau non support par le processeur est remplac par le meilleur disponible
+    if (kernel > palette_kernel()) {
+        kernel = palette_kernel();
+    }
+
+    void (*expand_row)(const uint8_t*, uint8_t*, int) = expand_row_scalar;
+#if PALETTE_X86
+    if (kernel == PaletteKernel::Avx2) {
+        expand_row = expand_row_avx2;
+    }
+    else if (kernel == PaletteKernel::Ssse3) {
+        expand_row = expand_row_ssse3;
+    }
+#endif
+
+    for (int y = 0; y < height; ++y) {
+        expand_row(indices + static_cast<size_t>(y) * width, dest + y * dest_pitch, width);
+    }
+}
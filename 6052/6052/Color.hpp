@@ -1,6 +1,7 @@
 #ifndef COLOR_HPP
 #define COLOR_HPP
 
+#include <cstddef>
 #include <cstdint>
 
 struct Color {
@@ -9,4 +10,17 @@ struct Color {
 
 Color color(uint8_t byte);
 
+enum class PaletteKernel {
+    Scalar,
+    Ssse3, // 16 pixels par itration
+    Avx2,  // 32 pixels par itration
+};
+
+// Meilleur noyau support par le processeur, dtect au premier appel
+PaletteKernel palette_kernel();
+
+// Convertit width x height indices de couleur en pixels RGBA ; dest_pitch octets sparent deux lignes de destination
+void expand_palette(const uint8_t* indices, int width, int height, uint8_t* dest, size_t dest_pitch);
+void expand_palette(const uint8_t* indices, int width, int height, uint8_t* dest, size_t dest_pitch, PaletteKernel kernel);
+
 #endif
@@ -0,0 +1,62 @@
+#include "Devices.hpp"
+
+// Chaque graine a sa propre suite de 2^32 tirages
+RandomDevice::RandomDevice(uint32_t seed) : counter(static_cast<uint64_t>(seed) << 32) {
+}
+
+void RandomDevice::attach(Bus& bus) {
+    bus.map_device(RANDOM_REGISTER, RANDOM_REGISTER, [this](uint16_t) {
+        return static_cast<uint8_t>(Bus::mix_hash(counter++) % 16 + 1);
+    }, nullptr);
+}
+
+KeyboardLatch::KeyboardLatch() : bus(nullptr) {
+}
+
+void KeyboardLatch::attach(Bus& bus_ref) {
+    bus = &bus_ref;
+}
+
+void KeyboardLatch::press(uint8_t key_code) {
+    if (bus) {
+        bus->mem_write(KEYBOARD_REGISTER, key_code);
+    }
+}
+
+uint8_t KeyboardLatch::last_key() const {
+    return bus ? bus->peek(KEYBOARD_REGISTER) : 0;
+}
+
+Framebuffer::Framebuffer() : bus(nullptr), dirty_rows(0xFFFFFFFF) {
+}
+
+void Framebuffer::attach(Bus& bus_ref) {
+    bus = &bus_ref;
+    // Appel avant que la RAM ne prenne la nouvelle valeur
+    bus_ref.map_device(FRAMEBUFFER_START, FRAMEBUFFER_START + FRAMEBUFFER_SIZE - 1, nullptr, [this](uint16_t addr, uint8_t data) {
+        if (bus->peek(addr) != data) {
+            dirty_rows |= 1u << ((addr - FRAMEBUFFER_START) / FRAMEBUFFER_WIDTH);
+        }
+    });
+}
+
+void Framebuffer::copy_pixels(uint8_t* dest) const {
+    if (bus) {
+        bus->read_ram(FRAMEBUFFER_START, dest, FRAMEBUFFER_SIZE);
+    }
+}
+
+// Une ligne ne chevauche jamais deux pages de la RAM
+const uint8_t* Framebuffer::row(int y) const {
+    return bus ? bus->ram(static_cast<uint16_t>(FRAMEBUFFER_START + y * FRAMEBUFFER_WIDTH)) : nullptr;
+}
+
+uint32_t Framebuffer::take_dirty_rows() {
+    uint32_t rows = dirty_rows;
+    dirty_rows = 0;
+    return rows;
+}
+
+void Framebuffer::invalidate() {
+    dirty_rows = 0xFFFFFFFF;
+}
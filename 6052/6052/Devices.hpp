@@ -0,0 +1,63 @@
+#ifndef DEVICES_HPP
+#define DEVICES_HPP
+
+#include "Bus.hpp"
+
+#include <cstdint>
+
+#define RANDOM_REGISTER 0x00FE
+#define KEYBOARD_REGISTER 0x00FF
+#define FRAMEBUFFER_START 0x0200
+#define FRAMEBUFFER_WIDTH 32
+#define FRAMEBUFFER_HEIGHT 32
+#define FRAMEBUFFER_SIZE (FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT)
+
+// $FE : un nouvel octet alatoire entre 1 et 16  chaque lecture.
+// Gnrateur  compteur (splitmix64) plutt que mt19937 : 8 octets d'tat par machine au lieu de 5 Ko
+class RandomDevice {
+public:
+    explicit RandomDevice(uint32_t seed);
+
+    void attach(Bus& bus);
+
+private:
+    uint64_t counter;
+};
+
+// $FF : code ASCII de la dernire touche presse, que le programme peut aussi craser.
+// Simple case de RAM crite par l'hte : elle suit donc les sauvegardes d'tat.
+class KeyboardLatch {
+public:
+    KeyboardLatch();
+
+    void attach(Bus& bus);
+    void press(uint8_t key);
+    uint8_t last_key() const;
+
+private:
+    Bus* bus;
+};
+
+// $0200-$05FF : cran de 32x32 pixels, un indice de couleur par octet.
+// Les pixels restent dans la RAM du bus ; le priphrique ne fait qu'observer les critures.
+class Framebuffer {
+public:
+    Framebuffer();
+
+    void attach(Bus& bus);
+    // Copie les FRAMEBUFFER_SIZE octets de l'cran dans dest, aprs attach()
+    void copy_pixels(uint8_t* dest) const;
+    // FRAMEBUFFER_WIDTH octets de la ligne y, valides jusqu' la prochaine criture dans l'cran
+    const uint8_t* row(int y) const;
+
+    // Lignes modifies depuis le dernier appel (bit y pour la ligne y), puis remise  zro
+    uint32_t take_dirty_rows();
+    // Toutes les lignes  redessiner, aprs une restauration de la RAM par exemple
+    void invalidate();
+
+private:
+    const Bus* bus;
+    uint32_t dirty_rows;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "Disassembler.hpp"
+#include "OpCodes.hpp"
+
+#include <cstring>
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// Oprande de chaque mode d'adressage : prfixe, nombre de chiffres hexadcimaux (0 : aucun), suffixe
+struct OperandFormat {
+    const char* prefix;
+    uint8_t digits;
+    const char* suffix;
+};
+
+// Index par AddressingMode, dans l'ordre de sa dclaration
+static const OperandFormat OPERAND_FORMATS[] = {
+    { "", 0, "" },      // Implied
+    { "A", 0, "" },     // Accumulator
+    { "#$", 2, "" },    // Immediate
+    { "$", 2, "" },     // ZeroPage
+    { "$", 2, ",X" },   // ZeroPage_X
+    { "$", 2, ",Y" },   // ZeroPage_Y
+    { "$", 4, "" },     // Relative, adresse de destination
+    { "$", 4, "" },     // Absolute
+    { "$", 4, ",X" },   // Absolute_X
+    { "$", 4, ",Y" },   // Absolute_Y
+    { "($", 4, ")" },   // Indirect
+    { "($", 2, ",X)" }, // Indirect_X
+    { "($", 2, "),Y" }, // Indirect_Y
+};
+static_assert(sizeof(OPERAND_FORMATS) / sizeof(OPERAND_FORMATS[0]) == static_cast<size_t>(AddressingMode::Indirect_Y) + 1,
+    "Un format par mode d'adressage");
+
+static char* append(char* out, const char* text) {
+    while (*text) {
+        *out++ = *text++;
+    }
+    return out;
+}
+
+static bool is_documented(const OpCode& opcode) {
+    return opcode.mnemonic[0] != '?';
+}
+
+char* format_hex8(char* out, uint8_t value) {
+    out[0] = HEX_DIGITS[value >> 4];
+    out[1] = HEX_DIGITS[value & 0x0F];
+    return out + 2;
+}
+
+char* format_hex16(char* out, uint16_t value) {
+    return format_hex8(format_hex8(out, static_cast<uint8_t>(value >> 8)), static_cast<uint8_t>(value));
+}
+
+uint8_t instruction_length(uint8_t opcode) {
+    return is_documented(OPCODES_TABLE[opcode]) ? OPCODES_TABLE[opcode].len : 1;
+}
+
+char* format_instruction(char* out, uint16_t pc, const uint8_t* bytes) {
+    const OpCode& opcode = OPCODES_TABLE[bytes[0]];
+    if (!is_documented(opcode)) {
+        out = append(out, ".byte $");
+        return format_hex8(out, bytes[0]);
+    }
+
+    std::memcpy(out, opcode.mnemonic, 3);
+    out += 3;
+    if (opcode.mode == AddressingMode::Implied) {
+        return out;
+    }
+
+    const OperandFormat& format = OPERAND_FORMATS[static_cast<size_t>(opcode.mode)];
+    *out++ = ' ';
+    out = append(out, format.prefix);
+    if (opcode.mode == AddressingMode::Relative) {
+        out = format_hex16(out, static_cast<uint16_t>(pc + 2 + static_cast<int8_t>(bytes[1])));
+    }
+    else if (format.digits == 4) {
+        out = format_hex16(out, static_cast<uint16_t>(bytes[1] | (bytes[2] << 8)));
+    }
+    else if (format.digits == 2) {
+        out = format_hex8(out, bytes[1]);
+    }
+    return append(out, format.suffix);
+}
+
+char* format_line(char* out, uint16_t pc, const uint8_t* bytes) {
+    out = format_hex16(out, pc);
+    *out++ = ' ';
+    *out++ = ' ';
+
+    // "4C F5 C5", complt par des espaces
+    uint8_t length = instruction_length(bytes[0]);
+    std::memset(out, ' ', 10);
+    for (uint8_t i = 0; i < length; ++i) {
+        format_hex8(out + i * 3, bytes[i]);
+    }
+    out += 10;
+    return format_instruction(out, pc, bytes);
+}
+
+size_t disassemble(const uint8_t* data, size_t size, uint16_t origin, char* out, size_t capacity, size_t& written) {
+    char* cursor = out;
+    char* limit = out + capacity;
+    size_t pos = 0;
+
+    while (pos < size && limit - cursor >= DISASSEMBLY_LINE_MAX) {
+        uint16_t pc = static_cast<uint16_t>(origin + pos);
+        uint8_t length = instruction_length(data[pos]);
+        if (length > size - pos) {
+            // Oprandes hors de data : l'opcode seul, comme un octet de donnes
+            cursor = format_hex16(cursor, pc);
+            cursor = append(cursor, "  ");
+            cursor = format_hex8(cursor, data[pos]);
+            cursor = append(cursor, "        .byte $");
+            cursor = format_hex8(cursor, data[pos]);
+            *cursor++ = '\n';
+            pos++;
+            continue;
+        }
+
+        cursor = format_line(cursor, pc, data + pos);
+        *cursor++ = '\n';
+        pos += length;
+    }
+
+    written = static_cast<size_t>(cursor - out);
+    return pos;
+}
@@ -0,0 +1,32 @@
+#ifndef DISASSEMBLER_HPP
+#define DISASSEMBLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// "JMP ($C5F5)" ou ".byte $02", le plus long texte d'instruction
+#define DISASSEMBLY_TEXT_MAX 11
+// "C000  4C F5 C5  JMP ($C5F5)\n"
+#define DISASSEMBLY_LINE_MAX (4 + 2 + 8 + 2 + DISASSEMBLY_TEXT_MAX + 1)
+
+// Dsassemblage pilot par OPCODES_TABLE et une table de formats par AddressingMode, sans allocation ni printf.
+// Chaque fonction crit  partir de out (sans '\0') et renvoie la fin du texte crit.
+// Les opcodes non documents s'crivent ".byte $XX", sur un octet.
+
+char* format_hex8(char* out, uint8_t value);
+char* format_hex16(char* out, uint16_t value);
+
+// Nombre d'octets de l'instruction qui commence par opcode
+uint8_t instruction_length(uint8_t opcode);
+
+// "LDA ($20),Y", "BNE $0610" : bytes contient l'opcode puis instruction_length(opcode) - 1 oprandes
+char* format_instruction(char* out, uint16_t pc, const uint8_t* bytes);
+// "0610  D0 F4     BNE $0606", sans fin de ligne : les octets occupent toujours 8 colonnes
+char* format_line(char* out, uint16_t pc, const uint8_t* bytes);
+
+// Une ligne par instruction de [data, data + size), charg en origin. N'crit que des lignes entires :
+// out doit pouvoir recevoir au moins DISASSEMBLY_LINE_MAX octets. Renvoie le nombre d'octets de data
+// dcods, written la taille du texte ; une instruction tronque en fin de data s'crit octet par octet.
+size_t disassemble(const uint8_t* data, size_t size, uint16_t origin, char* out, size_t capacity, size_t& written);
+
+#endif
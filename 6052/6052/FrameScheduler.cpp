@@ -0,0 +1,153 @@
+#include "FrameScheduler.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+// Au-del de ce retard on ne rattrape plus : on repart de maintenant
+#define MAX_LATE_FRAMES 4
+// Budget maximal d'un appel  CPU::run, loin de INT_MAX pour absorber le dpassement du dernier bloc
+#define MAX_RUN_BUDGET (INT_MAX / 2)
+
+FrameScheduler::FrameScheduler(uint32_t clock_hz, uint32_t frame_rate)
+    : clock_hz(clock_hz), frame_rate(frame_rate), remainder_accumulator(0), cycle_debt(0), overshoot(0),
+      cycles(0), frames(0), late(0), speed_multiplier(1.0), turbo_enabled(false), timer(nullptr) {
+    if (this->frame_rate == 0) {
+        std::cerr << "Frquence de trame nulle, 60 Hz utiliss" << std::endl;
+        this->frame_rate = 60;
+    }
+    cycles_per_frame = this->clock_hz / this->frame_rate;
+    remainder = this->clock_hz % this->frame_rate;
+
+#ifdef _WIN32
+    // Timer haute rsolution (Windows 10 1803+), sinon timer classique  la rsolution du systme
+    timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) {
+        timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+#endif
+    restart_clock();
+}
+
+FrameScheduler::~FrameScheduler() {
+#ifdef _WIN32
+    if (timer) {
+        CloseHandle(timer);
+    }
+#endif
+}
+
+void FrameScheduler::set_speed(double multiplier) {
+    if (multiplier <= 0.0) {
+        std::cerr << "Multiplicateur de vitesse invalide : " << multiplier << std::endl;
+        return;
+    }
+    speed_multiplier = multiplier;
+    restart_clock();
+}
+
+double FrameScheduler::speed() const {
+    return speed_multiplier;
+}
+
+void FrameScheduler::set_turbo(bool enabled) {
+    turbo_enabled = enabled;
+    restart_clock();
+}
+
+bool FrameScheduler::turbo() const {
+    return turbo_enabled;
+}
+
+void FrameScheduler::restart_clock() {
+    std::chrono::duration<double> period(1.0 / (frame_rate * speed_multiplier));
+    frame_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+    next_deadline = std::chrono::steady_clock::now();
+}
+
+int64_t FrameScheduler::run_frame(CPU& cpu) {
+    int64_t budget = cycles_per_frame;
+    remainder_accumulator += remainder;
+    if (remainder_accumulator >= frame_rate) {
+        remainder_accumulator -= frame_rate;
+        budget++;
+    }
+
+    // run(0) signifie  sans limite  : une trame entirement consomme par la dette n'excute rien
+    int64_t target = budget - cycle_debt;
+    int64_t consumed = 0;
+    // run compte en int : au-del de MAX_RUN_BUDGET cycles par trame, le reste passe dans les appels suivants
+    while (consumed < target) {
+        int slice = static_cast<int>(std::min<int64_t>(target - consumed, MAX_RUN_BUDGET));
+        int ran = cpu.run(slice);
+        consumed += ran;
+        if (ran < slice) {
+            break;
+        }
+    }
+
+    // Le CPU arrt (BRK) rend moins que demand : il n'y a alors rien  reporter
+    overshoot = (target > 0 && consumed > target) ? static_cast<int>(consumed - target) : 0;
+    cycle_debt = target < 0 ? -target : overshoot;
+    cycles += consumed;
+    frames++;
+    return consumed;
+}
+
+void FrameScheduler::wait_next_frame() {
+    if (turbo_enabled) {
+        return;
+    }
+
+    next_deadline += frame_period;
+    auto now = std::chrono::steady_clock::now();
+    if (next_deadline <= now) {
+        late++;
+        if (now - next_deadline > frame_period * MAX_LATE_FRAMES) {
+            next_deadline = now;
+        }
+        return;
+    }
+    sleep_until(next_deadline);
+}
+
+void FrameScheduler::sleep_until(std::chrono::steady_clock::time_point deadline) {
+#ifdef _WIN32
+    if (timer) {
+        auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+        LARGE_INTEGER due;
+        // Dure relative, en units de 100 ns
+        due.QuadPart = -static_cast<LONGLONG>(remaining.count() / 100);
+        if (due.QuadPart < 0 && SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+            WaitForSingleObject(timer, INFINITE);
+        }
+        return;
+    }
+#endif
+    std::this_thread::sleep_until(deadline);
+}
+
+int FrameScheduler::last_overshoot() const {
+    return overshoot;
+}
+
+uint64_t FrameScheduler::total_cycles() const {
+    return cycles;
+}
+
+uint64_t FrameScheduler::frame_count() const {
+    return frames;
+}
+
+uint64_t FrameScheduler::late_frames() const {
+    return late;
+}
@@ -0,0 +1,61 @@
+#ifndef FRAME_SCHEDULER_HPP
+#define FRAME_SCHEDULER_HPP
+
+#include "CPU.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+// Cadence l'mulation sur une horloge mule : chaque trame avance le CPU de exactement
+// clock_hz / frame_rate cycles, le reste de la division tant report d'une trame  l'autre.
+class FrameScheduler {
+public:
+    FrameScheduler(uint32_t clock_hz, uint32_t frame_rate);
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Multiplie la cadence des trames (2.0 : deux fois plus vite) sans changer les cycles par trame
+    void set_speed(double multiplier);
+    double speed() const;
+    // Turbo : plus aucune attente entre deux trames
+    void set_turbo(bool enabled);
+    bool turbo() const;
+
+    // Excute une trame ; le dpassement du budget (blocs indivisibles) est retranch de la suivante
+    int64_t run_frame(CPU& cpu);
+    // Dort jusqu' l'chance de la trame suivante (timer haute rsolution, pas d'attente active)
+    void wait_next_frame();
+
+    int last_overshoot() const;
+    uint64_t total_cycles() const;
+    uint64_t frame_count() const;
+    // Trames dont l'chance tait dj passe
+    uint64_t late_frames() const;
+
+private:
+    void restart_clock();
+    void sleep_until(std::chrono::steady_clock::time_point deadline);
+
+    uint32_t clock_hz;
+    uint32_t frame_rate;
+    uint32_t cycles_per_frame;
+    uint32_t remainder;
+    uint32_t remainder_accumulator;
+    int64_t cycle_debt;
+    int overshoot;
+    uint64_t cycles;
+    uint64_t frames;
+    uint64_t late;
+
+    double speed_multiplier;
+    bool turbo_enabled;
+    std::chrono::steady_clock::duration frame_period;
+    std::chrono::steady_clock::time_point next_deadline;
+
+    // HANDLE du timer Windows, nullptr ailleurs
+    void* timer;
+};
+
+#endif
@@ -0,0 +1,594 @@
+#include "Lockstep.hpp"
+#include "OpCodes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+#define LOCKSTEP_X86 1
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#else
+#define LOCKSTEP_X86 0
+#endif
+
+// Voies d'un groupe Avx512, le plus large : le nombre de voies est arrondi  un multiple
+#define LOCKSTEP_BLOCK 16
+
+// Ce que les voies d'un groupe font ensemble d'une instruction ; Scalar : chacune sur son CPU
+enum class LaneOp : uint8_t {
+    Scalar,
+    Load,
+    Store,
+    Adc,
+    Sbc,
+    And,
+    Ora,
+    Eor,
+    Compare,
+    Bit,
+    Increment, // INC, DEC, INX, INY, DEX et DEY
+    Asl,
+    Lsr,
+    Rol,
+    Ror,
+    Transfer,
+    Branch,
+    Jump,
+    Call,
+    Return,
+    Push,
+    Pull,
+    Flag,
+    Nop,
+};
+
+enum LaneRegister : uint8_t {
+    LANE_A,
+    LANE_X,
+    LANE_Y,
+    LANE_S,
+    LANE_P,
+    LANE_MEMORY,
+};
+
+struct LaneInstruction {
+    LaneOp op;
+    AddressingMode mode;
+    uint8_t reg;    // registre lu ou crit, LANE_MEMORY pour INC et DEC
+    uint8_t target; // destination d'un transfert
+    uint8_t flag;   // bit de P test par un branchement ou modifi par Flag
+    uint8_t value;  // branchement pris si le bit est  1 (1) ou  0 (0) ; Flag : nouvelle valeur ; Increment : 1 ou $FF
+    uint8_t len;
+    uint8_t cycles;
+    bool reads_memory;
+};
+
+static LaneInstruction lane_instruction(const OpCode& opcode) {
+    LaneInstruction instruction = { LaneOp::Scalar, opcode.mode, LANE_A, LANE_A, 0, 0, opcode.len, opcode.cycles, false };
+    std::string name = opcode.mnemonic;
+
+    struct Mapping {
+        const char* name;
+        LaneOp op;
+        uint8_t reg;
+        uint8_t target;
+        uint8_t flag;
+        uint8_t value;
+    };
+    static const Mapping MAPPINGS[] = {
+        { "LDA", LaneOp::Load, LANE_A, 0, 0, 0 }, { "LDX", LaneOp::Load, LANE_X, 0, 0, 0 }, { "LDY", LaneOp::Load, LANE_Y, 0, 0, 0 },
+        { "STA", LaneOp::Store, LANE_A, 0, 0, 0 }, { "STX", LaneOp::Store, LANE_X, 0, 0, 0 }, { "STY", LaneOp::Store, LANE_Y, 0, 0, 0 },
+        { "ADC", LaneOp::Adc, 0, 0, 0, 0 }, { "SBC", LaneOp::Sbc, 0, 0, 0, 0 },
+        { "AND", LaneOp::And, 0, 0, 0, 0 }, { "ORA", LaneOp::Ora, 0, 0, 0, 0 }, { "EOR", LaneOp::Eor, 0, 0, 0, 0 },
+        { "CMP", LaneOp::Compare, LANE_A, 0, 0, 0 }, { "CPX", LaneOp::Compare, LANE_X, 0, 0, 0 }, { "CPY", LaneOp::Compare, LANE_Y, 0, 0, 0 },
+        { "BIT", LaneOp::Bit, 0, 0, 0, 0 },
+        { "INC", LaneOp::Increment, LANE_MEMORY, 0, 0, 0x01 }, { "DEC", LaneOp::Increment, LANE_MEMORY, 0, 0, 0xFF },
+        { "INX", LaneOp::Increment, LANE_X, 0, 0, 0x01 }, { "INY", LaneOp::Increment, LANE_Y, 0, 0, 0x01 },
+        { "DEX", LaneOp::Increment, LANE_X, 0, 0, 0xFF }, { "DEY", LaneOp::Increment, LANE_Y, 0, 0, 0xFF },
+        { "ASL", LaneOp::Asl, 0, 0, 0, 0 }, { "LSR", LaneOp::Lsr, 0, 0, 0, 0 }, { "ROL", LaneOp::Rol, 0, 0, 0, 0 }, { "ROR", LaneOp::Ror, 0, 0, 0, 0 },
+        { "TAX", LaneOp::Transfer, LANE_A, LANE_X, 0, 0 }, { "TAY", LaneOp::Transfer, LANE_A, LANE_Y, 0, 0 },
+        { "TXA", LaneOp::Transfer, LANE_X, LANE_A, 0, 0 }, { "TYA", LaneOp::Transfer, LANE_Y, LANE_A, 0, 0 },
+        { "TSX", LaneOp::Transfer, LANE_S, LANE_X, 0, 0 }, { "TXS", LaneOp::Transfer, LANE_X, LANE_S, 0, 0 },
+        { "BPL", LaneOp::Branch, 0, 0, 0x80, 0 }, { "BMI", LaneOp::Branch, 0, 0, 0x80, 1 },
+        { "BVC", LaneOp::Branch, 0, 0, 0x40, 0 }, { "BVS", LaneOp::Branch, 0, 0, 0x40, 1 },
+        { "BCC", LaneOp::Branch, 0, 0, 0x01, 0 }, { "BCS", LaneOp::Branch, 0, 0, 0x01, 1 },
+        { "BNE", LaneOp::Branch, 0, 0, 0x02, 0 }, { "BEQ", LaneOp::Branch, 0, 0, 0x02, 1 },
+        { "JSR", LaneOp::Call, 0, 0, 0, 0 }, { "RTS", LaneOp::Return, 0, 0, 0, 0 },
+        { "PHA", LaneOp::Push, LANE_A, 0, 0, 0 }, { "PHP", LaneOp::Push, LANE_P, 0, 0, 0 },
+        { "PLA", LaneOp::Pull, LANE_A, 0, 0, 0 }, { "PLP", LaneOp::Pull, LANE_P, 0, 0, 0 },
+        { "CLC", LaneOp::Flag, 0, 0, 0x01, 0 }, { "SEC", LaneOp::Flag, 0, 0, 0x01, 0x01 },
+        { "CLI", LaneOp::Flag, 0, 0, 0x04, 0 }, { "SEI", LaneOp::Flag, 0, 0, 0x04, 0x04 },
+        { "CLD", LaneOp::Flag, 0, 0, 0x08, 0 }, { "SED", LaneOp::Flag, 0, 0, 0x08, 0x08 },
+        { "CLV", LaneOp::Flag, 0, 0, 0x40, 0 },
+        { "NOP", LaneOp::Nop, 0, 0, 0, 0 },
+    };
+    for (const Mapping& mapping : MAPPINGS) {
+        if (name == mapping.name) {
+            instruction.op = mapping.op;
+            instruction.reg = mapping.reg;
+            instruction.target = mapping.target;
+            instruction.flag = mapping.flag;
+            instruction.value = mapping.value;
+        }
+    }
+    // JMP ($xxxx) et son bogue de fin de page, BRK et RTI restent sur le CPU de chaque voie
+    if (name == "JMP" && opcode.mode == AddressingMode::Absolute) {
+        instruction.op = LaneOp::Jump;
+    }
+
+    bool operand_in_memory = opcode.mode != AddressingMode::Immediate && opcode.mode != AddressingMode::Accumulator;
+    switch (instruction.op) {
+    case LaneOp::Load: case LaneOp::Adc: case LaneOp::Sbc: case LaneOp::And: case LaneOp::Ora: case LaneOp::Eor:
+    case LaneOp::Compare: case LaneOp::Bit: case LaneOp::Asl: case LaneOp::Lsr: case LaneOp::Rol: case LaneOp::Ror:
+        instruction.reads_memory = operand_in_memory;
+        break;
+    case LaneOp::Increment:
+        instruction.reads_memory = instruction.reg == LANE_MEMORY;
+        break;
+    default:
+        break;
+    }
+    return instruction;
+}
+
+static std::array<LaneInstruction, 256> make_lane_instructions() {
+    std::array<LaneInstruction, 256> table;
+    for (size_t code = 0; code < table.size(); ++code) {
+        table[code] = lane_instruction(OPCODES_TABLE[code]);
+    }
+    return table;
+}
+
+static const std::array<LaneInstruction, 256> LANE_INSTRUCTIONS = make_lane_instructions();
+
+static int lane_count(unsigned lanes) {
+    return static_cast<int>(std::bitset<32>(lanes).count());
+}
+
+static int first_lane(unsigned lanes) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, lanes);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(lanes);
+#endif
+}
+
+struct Lockstep::Lane {
+    Lane(Bus& bus, const std::vector<uint8_t>& program, uint32_t seed) : cpu(bus), random(seed) {
+        random.attach(bus);
+        keyboard.attach(bus);
+        framebuffer.attach(bus);
+        cpu.load(program);
+        cpu.reset();
+    }
+
+    CPU cpu;
+    RandomDevice random;
+    KeyboardLatch keyboard;
+    Framebuffer framebuffer;
+};
+
+// Groupe de voies conscutives vu par un noyau : ses registres dans les tableaux du Lockstep et la RAM de ses bus
+struct LockstepGroup {
+    LockstepGroup(Lockstep& engine_ref, size_t first_ref)
+        : engine(engine_ref), first(first_ref),
+          ram(engine_ref.buses[first_ref - first_ref % LOCKSTEP_BLOCK].ram(0)), read_effects(engine_ref.read_effects.data()),
+          ram_offset(&engine_ref.ram_offset[first_ref]),
+          a(&engine_ref.register_a[first_ref]), x(&engine_ref.register_x[first_ref]), y(&engine_ref.register_y[first_ref]),
+          p(&engine_ref.status[first_ref]), s(&engine_ref.stack_pointer[first_ref]), pc(&engine_ref.program_counter[first_ref]),
+          running(&engine_ref.running[first_ref]), remaining(&engine_ref.remaining[first_ref]),
+          vector_count(0), scalar_count(0), step_count(0) {}
+
+    void step_scalar(int lane) {
+        engine.step_scalar(first + lane);
+    }
+
+    void write(int lane, uint16_t addr, uint8_t data) {
+        engine.buses[first + lane].mem_write(addr, data);
+    }
+
+    Lockstep& engine;
+    size_t first;
+    const uint8_t* ram;
+    const uint8_t* read_effects;
+    const int32_t* ram_offset;
+    uint32_t* a;
+    uint32_t* x;
+    uint32_t* y;
+    uint32_t* p;
+    uint32_t* s;
+    uint32_t* pc;
+    uint32_t* running;
+    int32_t* remaining;
+    uint64_t vector_count;
+    uint64_t scalar_count;
+    uint64_t step_count;
+};
+
+// Les trois noyaux partagent LockstepKernel.inc, compil dans chaque namespace avec son Vec
+namespace lockstep_scalar {
+struct Vec {
+    static constexpr int WIDTH = 8;
+    struct V {
+        uint32_t lane[WIDTH];
+    };
+    using M = unsigned;
+
+    static V load(const void* source) {
+        V v;
+        std::memcpy(v.lane, source, sizeof(v.lane));
+        return v;
+    }
+    static void store(void* dest, V v) {
+        std::memcpy(dest, v.lane, sizeof(v.lane));
+    }
+    static V set1(int value) {
+        V v;
+        for (int i = 0; i < WIDTH; ++i) {
+            v.lane[i] = static_cast<uint32_t>(value);
+        }
+        return v;
+    }
+#define LOCKSTEP_LANEWISE(name, expression) \
+    static V name(V a, V b) {               \
+        V v;                                \
+        for (int i = 0; i < WIDTH; ++i) {   \
+            v.lane[i] = expression;         \
+        }                                   \
+        return v;                           \
+    }
+    LOCKSTEP_LANEWISE(add, a.lane[i] + b.lane[i])
+    LOCKSTEP_LANEWISE(sub, a.lane[i] - b.lane[i])
+    LOCKSTEP_LANEWISE(band, a.lane[i] & b.lane[i])
+    LOCKSTEP_LANEWISE(bor, a.lane[i] | b.lane[i])
+    LOCKSTEP_LANEWISE(bxor, a.lane[i] ^ b.lane[i])
+#undef LOCKSTEP_LANEWISE
+    static V shl(V a, int count) {
+        for (int i = 0; i < WIDTH; ++i) {
+            a.lane[i] <<= count;
+        }
+        return a;
+    }
+    static V shr(V a, int count) {
+        for (int i = 0; i < WIDTH; ++i) {
+            a.lane[i] >>= count;
+        }
+        return a;
+    }
+    static M eq(V a, V b) {
+        M m = 0;
+        for (int i = 0; i < WIDTH; ++i) {
+            m |= (a.lane[i] == b.lane[i] ? 1u : 0u) << i;
+        }
+        return m;
+    }
+    static M gt(V a, V b) {
+        M m = 0;
+        for (int i = 0; i < WIDTH; ++i) {
+            m |= (static_cast<int32_t>(a.lane[i]) > static_cast<int32_t>(b.lane[i]) ? 1u : 0u) << i;
+        }
+        return m;
+    }
+    static M mand(M a, M b) { return a & b; }
+    static M mandnot(M a, M b) { return a & ~b; }
+    static unsigned bits(M m) { return m; }
+    static M from_bits(unsigned lanes) { return lanes; }
+    static V select(M m, V a, V b) {
+        for (int i = 0; i < WIDTH; ++i) {
+            if (m & (1u << i)) {
+                b.lane[i] = a.lane[i];
+            }
+        }
+        return b;
+    }
+    static V gather(const uint8_t* base, V index, M m) {
+        V v = set1(0);
+        for (int i = 0; i < WIDTH; ++i) {
+            if (m & (1u << i)) {
+                std::memcpy(&v.lane[i], base + static_cast<int32_t>(index.lane[i]), sizeof(uint32_t));
+            }
+        }
+        return v;
+    }
+};
+
+#include "LockstepKernel.inc"
+}
+
+#if LOCKSTEP_X86
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+namespace lockstep_avx2 {
+struct Vec {
+    static constexpr int WIDTH = 8;
+    using V = __m256i;
+    using M = __m256i; // voie  0xFFFFFFFF ou  0
+
+    static V load(const void* source) { return _mm256_loadu_si256(static_cast<const __m256i*>(source)); }
+    static void store(void* dest, V v) { _mm256_storeu_si256(static_cast<__m256i*>(dest), v); }
+    static V set1(int value) { return _mm256_set1_epi32(value); }
+    static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+    static V band(V a, V b) { return _mm256_and_si256(a, b); }
+    static V bor(V a, V b) { return _mm256_or_si256(a, b); }
+    static V bxor(V a, V b) { return _mm256_xor_si256(a, b); }
+    static V shl(V a, int count) { return _mm256_sllv_epi32(a, _mm256_set1_epi32(count)); }
+    static V shr(V a, int count) { return _mm256_srlv_epi32(a, _mm256_set1_epi32(count)); }
+    static M eq(V a, V b) { return _mm256_cmpeq_epi32(a, b); }
+    static M gt(V a, V b) { return _mm256_cmpgt_epi32(a, b); }
+    static M mand(M a, M b) { return _mm256_and_si256(a, b); }
+    static M mandnot(M a, M b) { return _mm256_andnot_si256(b, a); }
+    static unsigned bits(M m) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m))); }
+    static M from_bits(unsigned lanes) {
+        const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(lanes)), lane_bits), lane_bits);
+    }
+    static V select(M m, V a, V b) { return _mm256_blendv_epi8(b, a, m); }
+    static V gather(const uint8_t* base, V index, M m) {
+        return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(base), index, m, 1);
+    }
+};
+
+#include "LockstepKernel.inc"
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+namespace lockstep_avx512 {
+struct Vec {
+    static constexpr int WIDTH = 16;
+    using V = __m512i;
+    using M = __mmask16;
+
+    static V load(const void* source) { return _mm512_loadu_si512(source); }
+    static void store(void* dest, V v) { _mm512_storeu_si512(dest, v); }
+    static V set1(int value) { return _mm512_set1_epi32(value); }
+    static V add(V a, V b) { return _mm512_add_epi32(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_epi32(a, b); }
+    static V band(V a, V b) { return _mm512_and_si512(a, b); }
+    static V bor(V a, V b) { return _mm512_or_si512(a, b); }
+    static V bxor(V a, V b) { return _mm512_xor_si512(a, b); }
+    static V shl(V a, int count) { return _mm512_sllv_epi32(a, _mm512_set1_epi32(count)); }
+    static V shr(V a, int count) { return _mm512_srlv_epi32(a, _mm512_set1_epi32(count)); }
+    static M eq(V a, V b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    static M gt(V a, V b) { return _mm512_cmpgt_epi32_mask(a, b); }
+    static M mand(M a, M b) { return static_cast<M>(a & b); }
+    static M mandnot(M a, M b) { return static_cast<M>(a & ~b); }
+    static unsigned bits(M m) { return m; }
+    static M from_bits(unsigned lanes) { return static_cast<M>(lanes); }
+    static V select(M m, V a, V b) { return _mm512_mask_blend_epi32(m, b, a); }
+    static V gather(const uint8_t* base, V index, M m) {
+        return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, index, base, 1);
+    }
+};
+
+#include "LockstepKernel.inc"
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned registers[4]) {
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int*>(registers), static_cast<int>(leaf), static_cast<int>(subleaf));
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// Registres sauvegards par le systme aux changements de contexte (XCR0)
+static unsigned os_saved_state() {
+#if defined(_MSC_VER)
+    return static_cast<unsigned>(_xgetbv(0));
+#else
+    unsigned lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return lo;
+#endif
+}
+
+static LockstepKernel detect_lockstep_kernel() {
+    unsigned registers[4];
+    cpuid(0, 0, registers);
+    unsigned max_leaf = registers[0];
+
+    cpuid(1, 0, registers);
+    bool osxsave = registers[2] & (1u << 27);
+    bool avx = registers[2] & (1u << 28);
+    if (max_leaf < 7 || !osxsave || !avx) {
+        return LockstepKernel::Scalar;
+    }
+
+    unsigned saved = os_saved_state();
+    cpuid(7, 0, registers);
+    bool avx2 = (registers[1] & (1u << 5)) && (saved & 0x06) == 0x06;
+    // AVX-512F, et les registres zmm et k sauvegards
+    bool avx512 = avx2 && (registers[1] & (1u << 16)) && (saved & 0xE0) == 0xE0;
+
+    if (avx512) {
+        return LockstepKernel::Avx512;
+    }
+    return avx2 ? LockstepKernel::Avx2 : LockstepKernel::Scalar;
+}
+#else
+static LockstepKernel detect_lockstep_kernel() {
+    return LockstepKernel::Scalar;
+}
+#endif
+
+LockstepKernel lockstep_kernel() {
+    static const LockstepKernel kernel = detect_lockstep_kernel();
+    return kernel;
+}
+
+Lockstep::Lockstep(const std::vector<uint8_t>& program, const std::vector<uint32_t>& seeds)
+    : Lockstep(program, seeds, lockstep_kernel()) {}
+
+Lockstep::Lockstep(const std::vector<uint8_t>& program, const std::vector<uint32_t>& seeds, LockstepKernel kernel)
+    : selected_kernel(kernel > lockstep_kernel() ? lockstep_kernel() : kernel), lane_count(seeds.size()),
+      padded_count((seeds.size() + LOCKSTEP_BLOCK - 1) / LOCKSTEP_BLOCK * LOCKSTEP_BLOCK),
+      buses(new Bus[seeds.size()]), vector_count(0), scalar_count(0), step_count(0) {
+    // RAM des voies d'un seul bloc, sans partage de pages, plus une page pour les gathers 32 bits  $FFFF
+    std::shared_ptr<MemoryPage[]> ram_pages(new MemoryPage[lane_count * 0x100 + 1]());
+    for (size_t lane = 0; lane < lane_count; ++lane) {
+        buses[lane].use_contiguous_ram(ram_pages, lane * 0x100);
+        lane_machines.push_back(std::make_unique<Lane>(buses[lane], program, seeds[lane]));
+    }
+
+    register_a.assign(padded_count, 0);
+    register_x.assign(padded_count, 0);
+    register_y.assign(padded_count, 0);
+    status.assign(padded_count, 0);
+    stack_pointer.assign(padded_count, 0);
+    program_counter.assign(padded_count, 0);
+    running.assign(padded_count, 0);
+    remaining.assign(padded_count, 0);
+    ram_offset.assign(padded_count, 0);
+    total_cycles.assign(lane_count, 0);
+    for (size_t lane = 0; lane < lane_count; ++lane) {
+        CpuState state = lane_machines[lane]->cpu.get_state();
+        register_a[lane] = state.register_a;
+        register_x[lane] = state.register_x;
+        register_y[lane] = state.register_y;
+        status[lane] = state.status;
+        stack_pointer[lane] = state.stack_pointer;
+        program_counter[lane] = state.program_counter;
+        running[lane] = state.running ? 0xFFFFFFFF : 0;
+        // RAM alloue d'un bloc : l'cart entre deux voies d'un mme groupe tient largement sur 32 bits
+        ram_offset[lane] = static_cast<int32_t>(buses[lane].ram(0) - buses[lane - lane % LOCKSTEP_BLOCK].ram(0));
+    }
+
+    // Toutes les voies ont les mmes priphriques aux mmes adresses : la premire fait rfrence
+    read_effects.assign(0x10000 + 3, 0);
+    if (lane_count > 0) {
+        for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+            read_effects[addr] = buses[0].read_has_side_effects(static_cast<uint16_t>(addr)) ? 1 : 0;
+        }
+    }
+}
+
+// Les machines, dclares aprs les bus, sont dtruites avant eux
+Lockstep::~Lockstep() = default;
+
+int Lockstep::step_scalar(size_t lane) {
+    CPU& cpu = lane_machines[lane]->cpu;
+    cpu.set_state({ static_cast<uint8_t>(register_a[lane]), static_cast<uint8_t>(register_x[lane]), static_cast<uint8_t>(register_y[lane]),
+        static_cast<uint8_t>(status[lane]), static_cast<uint8_t>(stack_pointer[lane]), static_cast<uint16_t>(program_counter[lane]), running[lane] != 0 });
+    int cycles = cpu.step();
+
+    CpuState state = cpu.get_state();
+    register_a[lane] = state.register_a;
+    register_x[lane] = state.register_x;
+    register_y[lane] = state.register_y;
+    status[lane] = state.status;
+    stack_pointer[lane] = state.stack_pointer;
+    program_counter[lane] = state.program_counter;
+    running[lane] = state.running ? 0xFFFFFFFF : 0;
+    remaining[lane] -= cycles;
+    return cycles;
+}
+
+void Lockstep::run(int max_cycles) {
+    if (max_cycles <= 0) {
+        std::cerr << "Lockstep::run attend un budget de cycles positif" << std::endl;
+        return;
+    }
+    std::vector<int32_t> budgets(lane_count);
+    for (size_t lane = 0; lane < lane_count; ++lane) {
+        budgets[lane] = running[lane] ? max_cycles : 0;
+        remaining[lane] = budgets[lane];
+    }
+
+    void (*run_group)(LockstepGroup&) = lockstep_scalar::run_group;
+    size_t width = lockstep_scalar::Vec::WIDTH;
+#if LOCKSTEP_X86
+    if (selected_kernel == LockstepKernel::Avx512) {
+        run_group = lockstep_avx512::run_group;
+        width = lockstep_avx512::Vec::WIDTH;
+    }
+    else if (selected_kernel == LockstepKernel::Avx2) {
+        run_group = lockstep_avx2::run_group;
+        width = lockstep_avx2::Vec::WIDTH;
+    }
+#endif
+
+    for (size_t first = 0; first < lane_count; first += width) {
+        LockstepGroup group(*this, first);
+        run_group(group);
+        vector_count += group.vector_count;
+        scalar_count += group.scalar_count;
+        step_count += group.step_count;
+    }
+
+    for (size_t lane = 0; lane < lane_count; ++lane) {
+        total_cycles[lane] += static_cast<uint64_t>(budgets[lane] - remaining[lane]);
+    }
+}
+
+size_t Lockstep::lanes() const {
+    return lane_count;
+}
+
+LockstepKernel Lockstep::kernel() const {
+    return selected_kernel;
+}
+
+CpuState Lockstep::state(size_t lane) const {
+    return { static_cast<uint8_t>(register_a[lane]), static_cast<uint8_t>(register_x[lane]), static_cast<uint8_t>(register_y[lane]),
+        static_cast<uint8_t>(status[lane]), static_cast<uint8_t>(stack_pointer[lane]), static_cast<uint16_t>(program_counter[lane]), running[lane] != 0 };
+}
+
+uint64_t Lockstep::cycles(size_t lane) const {
+    return total_cycles[lane];
+}
+
+Bus& Lockstep::bus(size_t lane) {
+    return buses[lane];
+}
+
+KeyboardLatch& Lockstep::keyboard(size_t lane) {
+    return lane_machines[lane]->keyboard;
+}
+
+Framebuffer& Lockstep::framebuffer(size_t lane) {
+    return lane_machines[lane]->framebuffer;
+}
+
+uint64_t Lockstep::vector_instructions() const {
+    return vector_count;
+}
+
+uint64_t Lockstep::scalar_instructions() const {
+    return scalar_count;
+}
+
+uint64_t Lockstep::vector_steps() const {
+    return step_count;
+}
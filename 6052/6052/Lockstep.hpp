@@ -0,0 +1,91 @@
+#ifndef LOCKSTEP_HPP
+#define LOCKSTEP_HPP
+
+#include "Bus.hpp"
+#include "CPU.hpp"
+#include "Devices.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class LockstepKernel {
+    Scalar, // 8 voies par groupe, en C++ simple
+    Avx2,   // 8 voies par groupe, un registre ymm par registre du 6502
+    Avx512, // 16 voies par groupe, masques k
+};
+
+// Meilleur noyau support par le processeur, dtect au premier appel
+LockstepKernel lockstep_kernel();
+
+// Instances (voies) d'un mme programme excutes de front. A, X, Y, P, SP et PC sont rangs registre par registre
+// (structure de tableaux) et chaque groupe de voies avance d'une instruction  la fois : les voies au mme PC
+// excutent ensemble son opcode, oprandes lus dans la RAM de chaque bus par des gathers, pendant que les autres
+// attendent de les rejoindre. Une instruction qui lit un priphrique, ou que le noyau ne sait pas excuter de front
+// (BRK, RTI, JMP indirect), passe par le CPU de la voie.
+// Chaque voie a sa machine complte (bus, CPU, priphriques) et se comporte exactement comme CPU::step en boucle.
+class Lockstep {
+public:
+    // Une voie par graine de $FE
+    Lockstep(const std::vector<uint8_t>& program, const std::vector<uint32_t>& seeds);
+    Lockstep(const std::vector<uint8_t>& program, const std::vector<uint32_t>& seeds, LockstepKernel kernel);
+    ~Lockstep();
+
+    Lockstep(const Lockstep&) = delete;
+    Lockstep& operator=(const Lockstep&) = delete;
+
+    // Chaque voie encore en marche excute au moins max_cycles cycles,  l'instruction prs, ou jusqu' son BRK
+    void run(int max_cycles);
+
+    size_t lanes() const;
+    LockstepKernel kernel() const;
+
+    CpuState state(size_t lane) const;
+    uint64_t cycles(size_t lane) const;
+    // Les touches se donnent entre deux run ; la RAM se lit et s'crit par le bus
+    Bus& bus(size_t lane);
+    KeyboardLatch& keyboard(size_t lane);
+    Framebuffer& framebuffer(size_t lane);
+
+    // Instructions excutes de front et sur le CPU de leur voie, comptes par voie
+    uint64_t vector_instructions() const;
+    uint64_t scalar_instructions() const;
+    // Pas de groupe excuts de front : vector_instructions() / vector_steps() voies occupes en moyenne
+    uint64_t vector_steps() const;
+
+private:
+    struct Lane;
+    friend struct LockstepGroup;
+
+    int step_scalar(size_t lane);
+
+    LockstepKernel selected_kernel;
+    size_t lane_count;
+    size_t padded_count; // multiple de la largeur du plus grand groupe
+
+    // RAM des bus contigu (Bus::use_contiguous_ram) : les gathers d'un groupe l'adressent par un dcalage 32 bits
+    std::unique_ptr<Bus[]> buses;
+    std::vector<std::unique_ptr<Lane>> lane_machines;
+
+    // Un lment par voie, voies de bourrage comprises (jamais en marche)
+    std::vector<uint32_t> register_a;
+    std::vector<uint32_t> register_x;
+    std::vector<uint32_t> register_y;
+    std::vector<uint32_t> status;
+    std::vector<uint32_t> stack_pointer;
+    std::vector<uint32_t> program_counter;
+    std::vector<uint32_t> running;   // 0 ou 0xFFFFFFFF
+    std::vector<int32_t> remaining;  // cycles restant  excuter dans le run en cours
+    std::vector<int32_t> ram_offset; // RAM de la voie moins celle de la premire voie de son groupe
+    std::vector<uint64_t> total_cycles;
+
+    // 1 pour les adresses dont la lecture a un effet (priphriques des voies), 3 octets de marge pour les gathers 32 bits
+    std::vector<uint8_t> read_effects;
+
+    uint64_t vector_count;
+    uint64_t scalar_count;
+    uint64_t step_count;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "Machine.hpp"
+
+Machine::Machine(const ProgramImage& program, uint32_t seed) : cpu(bus), random(seed) {
+    attach_devices();
+    cpu.load(program);
+    cpu.reset();
+}
+
+Machine::Machine(Machine& parent) : cpu(bus), random(parent.random) {
+    attach_devices();
+    bus.share_ram(parent.bus);
+    cpu.set_state(parent.cpu.get_state());
+}
+
+void Machine::attach_devices() {
+    random.attach(bus);
+    keyboard.attach(bus);
+    framebuffer.attach(bus);
+}
+
+std::unique_ptr<Machine> Machine::fork() {
+    return std::unique_ptr<Machine>(new Machine(*this));
+}
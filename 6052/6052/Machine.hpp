@@ -0,0 +1,37 @@
+#ifndef MACHINE_HPP
+#define MACHINE_HPP
+
+#include "Bus.hpp"
+#include "CPU.hpp"
+#include "Devices.hpp"
+
+#include <cstdint>
+#include <memory>
+
+// Machine complte d'un programme de dmonstration : bus, CPU, gnrateur de $FE, clavier et cran.
+// fork() la duplique pour explorer plusieurs suites de touches  partir d'un mme tat.
+class Machine {
+public:
+    Machine(const ProgramImage& program, uint32_t seed);
+
+    Machine(const Machine&) = delete;
+    Machine& operator=(const Machine&) = delete;
+
+    // Nouvelle machine dans le mme tat, pour le prix d'une table des pages : les deux partagent leur RAM page par
+    // page jusqu' la premire criture de l'une d'elles, et une page est libre avec la dernire machine qui la
+    // rfrence. Registres et gnrateur sont copis ; les points d'arrt et de surveillance ne suivent pas
+    std::unique_ptr<Machine> fork();
+
+    Bus bus;
+    CPU cpu;
+    RandomDevice random;
+    KeyboardLatch keyboard;
+    Framebuffer framebuffer;
+
+private:
+    explicit Machine(Machine& parent);
+
+    void attach_devices();
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "Movie.hpp"
+#include "BlockCache.hpp"
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// Budget maximal d'un appel  CPU::run, loin de INT_MAX pour absorber le dpassement
+#define MAX_RUN_BUDGET (INT_MAX / 2)
+
+static void write_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+static void write_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool read_u32(const std::vector<uint8_t>& in, size_t& pos, uint32_t& value) {
+    if (in.size() - pos < 4) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(in[pos++]) << (i * 8);
+    }
+    return true;
+}
+
+static bool read_varint(const std::vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        uint8_t byte = in[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t program_hash(const std::vector<uint8_t>& program) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t byte : program) {
+        hash = (hash ^ byte) * 16777619u;
+    }
+    return hash;
+}
+
+void Movie::record_key(uint64_t cycle, uint8_t key) {
+    events.push_back({ cycle, InputKind::Key, key });
+}
+
+// MOVIE_MAGIC, seed, program_hash, end_cycle (varint), nombre d'vnements (varint),
+// puis par vnement : delta de cycle (varint), type, valeur
+std::vector<uint8_t> Movie::serialize() const {
+    std::vector<uint8_t> data(MOVIE_MAGIC, MOVIE_MAGIC + 8);
+    write_u32(data, seed);
+    write_u32(data, program_hash);
+    write_varint(data, end_cycle);
+    write_varint(data, events.size());
+
+    uint64_t previous = 0;
+    for (const InputEvent& event : events) {
+        write_varint(data, event.cycle - previous);
+        data.push_back(static_cast<uint8_t>(event.kind));
+        data.push_back(event.value);
+        previous = event.cycle;
+    }
+    return data;
+}
+
+bool Movie::deserialize(const std::vector<uint8_t>& data) {
+    size_t pos = 8;
+    uint64_t count = 0;
+    if (data.size() < pos || std::memcmp(data.data(), MOVIE_MAGIC, 8) != 0 ||
+        !read_u32(data, pos, seed) || !read_u32(data, pos, program_hash) ||
+        !read_varint(data, pos, end_cycle) || !read_varint(data, pos, count)) {
+        std::cerr << "En-tte de film invalide" << std::endl;
+        return false;
+    }
+
+    events.clear();
+    uint64_t cycle = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t delta = 0;
+        if (!read_varint(data, pos, delta) || data.size() - pos < 2) {
+            std::cerr << "Film tronqu aprs " << i << " vnements" << std::endl;
+            return false;
+        }
+        cycle += delta;
+        InputKind kind = static_cast<InputKind>(data[pos++]);
+        if (kind != InputKind::Key) {
+            std::cerr << "Type d'vnement inconnu : " << static_cast<int>(kind) << std::endl;
+            return false;
+        }
+        events.push_back({ cycle, kind, data[pos++] });
+    }
+    return true;
+}
+
+bool Movie::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    std::vector<uint8_t> data = serialize();
+    if (!file || !file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+        std::cerr << "Impossible d'crire le film " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Movie::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossible d'ouvrir le film " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return deserialize(data);
+}
+
+InputPlayer::InputPlayer(const Movie& movie, KeyboardLatch& keyboard)
+    : events(movie.events), keyboard(keyboard), next_event(0), cycle(0) {
+}
+
+void InputPlayer::apply_pending() {
+    while (next_event < events.size() && events[next_event].cycle <= cycle) {
+        keyboard.press(events[next_event].value);
+        next_event++;
+    }
+}
+
+int InputPlayer::run(CPU& cpu, int max_cycles) {
+    int consumed = 0;
+    while (cpu.is_cpu_running() && (max_cycles <= 0 || consumed < max_cycles)) {
+        int remaining = max_cycles > 0 ? max_cycles - consumed : MAX_RUN_BUDGET;
+
+        if (next_event >= events.size()) {
+            int cycles = cpu.run(max_cycles > 0 ? remaining : -1);
+            cycle += cycles;
+            consumed += cycles;
+            break;
+        }
+
+        // Loin du prochain vnement : run() sans hook ne peut pas dpasser de plus d'un bloc
+        uint64_t event_cycle = events[next_event].cycle;
+        if (event_cycle > cycle + MAX_BLOCK_CYCLES) {
+            uint64_t safe = event_cycle - cycle - MAX_BLOCK_CYCLES;
+            int budget = safe < static_cast<uint64_t>(remaining) ? static_cast<int>(safe) : remaining;
+            int cycles = cpu.run(budget);
+            cycle += cycles;
+            consumed += cycles;
+        }
+        else {
+            // on_execute fait avancer cycle et applique l'vnement avant la bonne instruction
+            int budget = static_cast<int>(event_cycle > cycle ? event_cycle - cycle + 1 : 1);
+            consumed += cpu.run_with_callback(*this, budget < remaining ? budget : remaining);
+        }
+
+        // Point d'arrt ou de surveillance : la main revient  l'appelant
+        if (cpu.stop_info().reason != StopReason::Budget) {
+            break;
+        }
+    }
+    return consumed;
+}
+
+uint64_t InputPlayer::current_cycle() const {
+    return cycle;
+}
+
+bool InputPlayer::finished() const {
+    return next_event >= events.size();
+}
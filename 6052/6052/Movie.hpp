@@ -0,0 +1,76 @@
+#ifndef MOVIE_HPP
+#define MOVIE_HPP
+
+#include "CPU.hpp"
+#include "Devices.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Version 2 : suite de $FE tire par splitmix64, les films de la version 1 ne se rejouent plus  l'identique
+#define MOVIE_MAGIC "6502MOV2"
+
+enum class InputKind : uint8_t {
+    Key, // value crit dans KeyboardLatch
+};
+
+// Entre injecte par l'hte, visible  partir de la premire instruction qui commence au cycle donn ou aprs
+struct InputEvent {
+    uint64_t cycle;
+    InputKind kind;
+    uint8_t value;
+};
+
+// Tout ce que l'hte injecte dans une excution : la graine de $FE, les touches et leur cycle.
+// Avec le mme programme, rejouer ces entres reproduit l'excution  l'identique.
+struct Movie {
+    uint32_t seed = 0;
+    uint32_t program_hash = 0;
+    uint64_t end_cycle = 0;
+    std::vector<InputEvent> events;
+
+    void record_key(uint64_t cycle, uint8_t key);
+
+    // Cycles en deltas LEB128 : quelques octets par vnement
+    std::vector<uint8_t> serialize() const;
+    bool deserialize(const std::vector<uint8_t>& data);
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+// FNV-1a, pour vrifier qu'un film est rejou sur le programme enregistr
+uint32_t program_hash(const std::vector<uint8_t>& program);
+
+// Rejoue les vnements d'un film au cycle exact. run() excute sans hook jusqu' l'approche
+// du prochain vnement, puis passe par on_execute pour l'appliquer avant la bonne instruction.
+class InputPlayer {
+public:
+    static constexpr uint8_t hook_mask = HOOK_EXECUTE;
+
+    InputPlayer(const Movie& movie, KeyboardLatch& keyboard);
+
+    void on_execute(const CPU&, const DecodedInstruction& instruction) {
+        if (next_event < events.size() && events[next_event].cycle <= cycle) {
+            apply_pending();
+        }
+        cycle += instruction.cycles;
+    }
+
+    // Mme contrat que CPU::run
+    int run(CPU& cpu, int max_cycles);
+
+    uint64_t current_cycle() const;
+    bool finished() const;
+
+private:
+    void apply_pending();
+
+    const std::vector<InputEvent>& events;
+    KeyboardLatch& keyboard;
+    size_t next_event;
+    uint64_t cycle;
+};
+
+#endif
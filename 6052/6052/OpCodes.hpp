@@ -1,10 +1,10 @@
 #ifndef OPCODES_H
 #define OPCODES_H
 
-#include <unordered_map>
-#include <vector>
+#include "CPU.hpp"
 
-enum class AddressingMode;
+#include <array>
+#include <cstdint>
 
 struct OpCode {
     uint8_t code;
@@ -12,12 +12,16 @@ struct OpCode {
     uint8_t len;
     uint8_t cycles;
     AddressingMode mode;
+    OpHandler handler;
 
-    OpCode(uint8_t c, const char* m, uint8_t l, uint8_t cy, AddressingMode mo)
-        : code(c), mnemonic(m), len(l), cycles(cy), mode(mo) {}
+    constexpr OpCode()
+        : code(0), mnemonic("???"), len(1), cycles(2), mode(AddressingMode::Implied), handler(nullptr) {}
+
+    constexpr OpCode(uint8_t c, const char* m, uint8_t l, uint8_t cy, AddressingMode mo, OpHandler h)
+        : code(c), mnemonic(m), len(l), cycles(cy), mode(mo), handler(h) {}
 };
 
-extern const std::vector<OpCode> CPU_OPS_CODES;
-extern const std::unordered_map<uint8_t, const OpCode*> OPCODES_MAP;
+// Index directement par l'octet d'opcode ; les 105 opcodes non documents pointent sur CPU::TRAP
+extern const std::array<OpCode, 256> OPCODES_TABLE;
 
 #endif
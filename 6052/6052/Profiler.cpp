@@ -0,0 +1,103 @@
+#include "Profiler.hpp"
+#include "OpCodes.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+Profiler::Profiler() : pc_counts(0x10000), pc_cycles(0x10000), pc_codes(0x10000) {
+    clear();
+}
+
+void Profiler::clear() {
+    opcode_counts.fill(0);
+    opcode_cycles.fill(0);
+    std::fill(pc_counts.begin(), pc_counts.end(), 0);
+    std::fill(pc_cycles.begin(), pc_cycles.end(), 0);
+    std::fill(pc_codes.begin(), pc_codes.end(), 0);
+}
+
+uint64_t Profiler::total_instructions() const {
+    uint64_t total = 0;
+    for (uint64_t count : opcode_counts) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t Profiler::total_cycles() const {
+    uint64_t total = 0;
+    for (uint64_t cycles : opcode_cycles) {
+        total += cycles;
+    }
+    return total;
+}
+
+uint64_t Profiler::opcode_count(uint8_t code) const {
+    return opcode_counts[code];
+}
+
+uint64_t Profiler::opcode_cycle_count(uint8_t code) const {
+    return opcode_cycles[code];
+}
+
+uint64_t Profiler::pc_count(uint16_t pc) const {
+    return pc_counts[pc];
+}
+
+uint64_t Profiler::pc_cycle_count(uint16_t pc) const {
+    return pc_cycles[pc];
+}
+
+// Adresses excutes au moins une fois, les plus coteuses d'abord
+std::vector<uint16_t> Profiler::hot_pcs() const {
+    std::vector<uint16_t> pcs;
+    for (size_t pc = 0; pc < pc_counts.size(); ++pc) {
+        if (pc_counts[pc] != 0) {
+            pcs.push_back(static_cast<uint16_t>(pc));
+        }
+    }
+    std::stable_sort(pcs.begin(), pcs.end(), [this](uint16_t a, uint16_t b) {
+        return pc_cycles[a] > pc_cycles[b];
+    });
+    return pcs;
+}
+
+void Profiler::write_collapsed(std::ostream& out) const {
+    char line[64];
+    for (uint16_t pc : hot_pcs()) {
+        std::snprintf(line, sizeof(line), "6502;$%04X %s %llu\n", pc, OPCODES_TABLE[pc_codes[pc]].mnemonic,
+            static_cast<unsigned long long>(pc_cycles[pc]));
+        out << line;
+    }
+}
+
+void Profiler::write_json(std::ostream& out, size_t max_pcs) const {
+    char line[160];
+    out << "{\n  \"instructions\": " << total_instructions() << ",\n  \"cycles\": " << total_cycles() << ",\n  \"opcodes\": [";
+
+    std::vector<uint8_t> codes;
+    for (size_t code = 0; code < opcode_counts.size(); ++code) {
+        if (opcode_counts[code] != 0) {
+            codes.push_back(static_cast<uint8_t>(code));
+        }
+    }
+    std::stable_sort(codes.begin(), codes.end(), [this](uint8_t a, uint8_t b) {
+        return opcode_cycles[a] > opcode_cycles[b];
+    });
+    for (size_t i = 0; i < codes.size(); ++i) {
+        std::snprintf(line, sizeof(line), "%s\n    {\"opcode\": \"0x%02X\", \"mnemonic\": \"%s\", \"count\": %llu, \"cycles\": %llu}",
+            i == 0 ? "" : ",", codes[i], OPCODES_TABLE[codes[i]].mnemonic,
+            static_cast<unsigned long long>(opcode_counts[codes[i]]), static_cast<unsigned long long>(opcode_cycles[codes[i]]));
+        out << line;
+    }
+
+    out << "\n  ],\n  \"hot_pcs\": [";
+    std::vector<uint16_t> pcs = hot_pcs();
+    for (size_t i = 0; i < pcs.size() && i < max_pcs; ++i) {
+        std::snprintf(line, sizeof(line), "%s\n    {\"pc\": \"$%04X\", \"mnemonic\": \"%s\", \"count\": %llu, \"cycles\": %llu}",
+            i == 0 ? "" : ",", pcs[i], OPCODES_TABLE[pc_codes[pcs[i]]].mnemonic,
+            static_cast<unsigned long long>(pc_counts[pcs[i]]), static_cast<unsigned long long>(pc_cycles[pcs[i]]));
+        out << line;
+    }
+    out << "\n  ]\n}\n";
+}
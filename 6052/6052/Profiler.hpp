@@ -0,0 +1,53 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "CPU.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Compte excutions et cycles par opcode et par adresse. S'utilise comme hook :
+// cpu.run_with_callback(profiler, cycles) ; run() ne l'instancie pas et ne paie donc rien.
+class Profiler {
+public:
+    static constexpr uint8_t hook_mask = HOOK_EXECUTE;
+
+    Profiler();
+
+    void on_execute(const CPU&, const DecodedInstruction& instruction) {
+        opcode_counts[instruction.code]++;
+        opcode_cycles[instruction.code] += instruction.cycles;
+        pc_counts[instruction.address]++;
+        pc_cycles[instruction.address] += instruction.cycles;
+        pc_codes[instruction.address] = instruction.code;
+    }
+
+    void clear();
+
+    uint64_t total_instructions() const;
+    uint64_t total_cycles() const;
+    uint64_t opcode_count(uint8_t code) const;
+    uint64_t opcode_cycle_count(uint8_t code) const;
+    uint64_t pc_count(uint16_t pc) const;
+    uint64_t pc_cycle_count(uint16_t pc) const;
+
+    // Une ligne "6502;$PPPP MNEMONIC cycles" par adresse excute, pour flamegraph.pl ou speedscope
+    void write_collapsed(std::ostream& out) const;
+    // Totaux, opcodes et les max_pcs adresses les plus coteuses en cycles
+    void write_json(std::ostream& out, size_t max_pcs = 32) const;
+
+private:
+    std::vector<uint16_t> hot_pcs() const;
+
+    std::array<uint64_t, 256> opcode_counts;
+    std::array<uint64_t, 256> opcode_cycles;
+    std::vector<uint64_t> pc_counts;
+    std::vector<uint64_t> pc_cycles;
+    // Dernier opcode excut  chaque adresse (le code peut se modifier lui-mme)
+    std::vector<uint8_t> pc_codes;
+};
+
+#endif
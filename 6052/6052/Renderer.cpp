@@ -80,9 +80,9 @@ HRESULT Renderer::InitD3D(HWND hwnd)
     desc.ArraySize = 1;
     desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.Usage = D3D11_USAGE_DEFAULT;
     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.CPUAccessFlags = 0;
 
     hr = dev->CreateTexture2D(&desc, NULL, &pFrameBufferTexture);
     if (FAILED(hr))
@@ -223,29 +223,26 @@ HRESULT Renderer::InitD3D(HWND hwnd)
     return S_OK;
 }
 
-void Renderer::RenderFrame(const std::vector<uint8_t>& screen_state)
+void Renderer::RenderFrame(const std::vector<uint8_t>& screen_state, uint32_t dirty_rows)
 {
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-    HRESULT hr = devcon->Map(pFrameBufferTexture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-    if (SUCCEEDED(hr))
+    // Une copie par groupe de lignes modifies conscutives
+    int y = 0;
+    while (y < 32)
     {
-        uint8_t* pTexels = (uint8_t*)mappedResource.pData;
+        if (!(dirty_rows & (1u << y)))
+        {
+            y++;
+            continue;
+        }
 
-        for (int y = 0; y < 32; y++)
+        int first = y;
+        while (y < 32 && (dirty_rows & (1u << y)))
         {
-            for (int x = 0; x < 32; x++)
-            {
-                int index = (y * 32 + x) * 3;
-                int texelIndex = y * mappedResource.RowPitch + x * 4;
-
-                pTexels[texelIndex] = screen_state[index];
-                pTexels[texelIndex + 1] = screen_state[index + 1];
-                pTexels[texelIndex + 2] = screen_state[index + 2];
-                pTexels[texelIndex + 3] = 255;
-            }
+            y++;
         }
 
-        devcon->Unmap(pFrameBufferTexture, 0);
+        D3D11_BOX box = { 0, static_cast<UINT>(first), 0, 32, static_cast<UINT>(y), 1 };
+        devcon->UpdateSubresource(pFrameBufferTexture, 0, &box, &screen_state[first * 32 * 4], 32 * 4, 0);
     }
 
     float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -20,7 +20,8 @@ public:
     ~Renderer();
 
     HRESULT InitD3D(HWND hwnd);
-    void RenderFrame(const std::vector<uint8_t>& screen_state);
+    // screen_state : 32x32 pixels RGBA ; seules les lignes de dirty_rows sont envoyes  la texture
+    void RenderFrame(const std::vector<uint8_t>& screen_state, uint32_t dirty_rows);
     void CleanD3D();
 
 private:
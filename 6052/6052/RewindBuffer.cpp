@@ -0,0 +1,177 @@
+#include "RewindBuffer.hpp"
+
+#include <cstring>
+
+#define RAM_SIZE 0x10000
+#define REGISTERS_SIZE 8
+#define IMAGE_SIZE (RAM_SIZE + REGISTERS_SIZE)
+#define CHUNK_SIZE 0x100
+// 256 pages de RAM puis un morceau de REGISTERS_SIZE octets pour les registres
+#define CHUNK_COUNT (RAM_SIZE / CHUNK_SIZE + 1)
+
+// Octet de contrle des plages : bit 7  1, (c & 0x7F) + 1 octets suivent tels quels ;  0, c + 1 zros
+#define RUN_LITERAL 0x80
+#define MAX_RUN 0x80
+
+RewindBuffer::RewindBuffer(size_t memory_budget, size_t keyframe_interval)
+    : budget(memory_budget), interval(keyframe_interval ? keyframe_interval : 1), used(0), since_keyframe(0),
+      current(IMAGE_SIZE, 0), scratch(IMAGE_SIZE, 0), zeros(IMAGE_SIZE, 0) {
+}
+
+void RewindBuffer::capture(const CPU& cpu, const Bus& bus, std::vector<uint8_t>& image) const {
+    bus.read_ram(0, image.data(), RAM_SIZE);
+    CpuState registers = cpu.get_state();
+    uint8_t* tail = &image[RAM_SIZE];
+    tail[0] = registers.register_a;
+    tail[1] = registers.register_x;
+    tail[2] = registers.register_y;
+    tail[3] = registers.status;
+    tail[4] = registers.stack_pointer;
+    tail[5] = static_cast<uint8_t>(registers.program_counter);
+    tail[6] = static_cast<uint8_t>(registers.program_counter >> 8);
+    tail[7] = registers.running ? 1 : 0;
+}
+
+// Par morceau modifi : indice sur 16 bits puis le XOR en plages, jusqu' couvrir tout le morceau
+std::vector<uint8_t> RewindBuffer::encode(const uint8_t* image, const uint8_t* previous) {
+    std::vector<uint8_t> out;
+    uint8_t diff[CHUNK_SIZE];
+
+    for (size_t chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+        size_t offset = chunk * CHUNK_SIZE;
+        size_t length = chunk < CHUNK_COUNT - 1 ? CHUNK_SIZE : REGISTERS_SIZE;
+        if (std::memcmp(image + offset, previous + offset, length) == 0) {
+            continue;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            diff[i] = image[offset + i] ^ previous[offset + i];
+        }
+
+        out.push_back(static_cast<uint8_t>(chunk));
+        out.push_back(static_cast<uint8_t>(chunk >> 8));
+        size_t pos = 0;
+        while (pos < length) {
+            size_t run = 0;
+            if (diff[pos] == 0) {
+                while (pos + run < length && run < MAX_RUN && diff[pos + run] == 0) {
+                    run++;
+                }
+                out.push_back(static_cast<uint8_t>(run - 1));
+            }
+            else {
+                while (pos + run < length && run < MAX_RUN && diff[pos + run] != 0) {
+                    run++;
+                }
+                out.push_back(static_cast<uint8_t>(RUN_LITERAL | (run - 1)));
+                out.insert(out.end(), diff + pos, diff + pos + run);
+            }
+            pos += run;
+        }
+    }
+    return out;
+}
+
+void RewindBuffer::apply(std::vector<uint8_t>& image, const std::vector<uint8_t>& delta) {
+    size_t pos = 0;
+    while (pos + 2 <= delta.size()) {
+        size_t chunk = delta[pos] | (delta[pos + 1] << 8);
+        pos += 2;
+        size_t offset = chunk * CHUNK_SIZE;
+        size_t length = chunk < CHUNK_COUNT - 1 ? CHUNK_SIZE : REGISTERS_SIZE;
+
+        size_t done = 0;
+        while (done < length) {
+            uint8_t control = delta[pos++];
+            size_t run = (control & ~RUN_LITERAL) + 1;
+            if (control & RUN_LITERAL) {
+                for (size_t i = 0; i < run; ++i) {
+                    image[offset + done + i] ^= delta[pos + i];
+                }
+                pos += run;
+            }
+            done += run;
+        }
+    }
+}
+
+size_t RewindBuffer::entry_size(const Entry& entry) {
+    return sizeof(Entry) + entry.delta.size() + entry.keyframe.size();
+}
+
+void RewindBuffer::push(const CPU& cpu, const Bus& bus) {
+    capture(cpu, bus, scratch);
+
+    Entry entry;
+    entry.delta = encode(scratch.data(), entries.empty() ? zeros.data() : current.data());
+    if (entries.empty() || ++since_keyframe >= interval) {
+        entry.keyframe = entries.empty() ? entry.delta : encode(scratch.data(), zeros.data());
+        since_keyframe = 0;
+    }
+    current.swap(scratch);
+
+    used += entry_size(entry);
+    entries.push_back(std::move(entry));
+
+    // L'entre la plus rcente est toujours garde, mme seule au-del du budget
+    while (used > budget && entries.size() > 1) {
+        used -= entry_size(entries.front());
+        entries.pop_front();
+    }
+}
+
+bool RewindBuffer::rewind(CPU& cpu, Bus& bus, size_t frames) {
+    if (entries.empty()) {
+        return false;
+    }
+    size_t last = entries.size() - 1;
+    size_t target = frames < last ? last - frames : 0;
+
+    // Point de dpart le plus proche de la cible : une keyframe entre la cible et la fin, sinon l'tat courant
+    size_t position = target;
+    while (position < last && entries[position].keyframe.empty()) {
+        position++;
+    }
+    if (position < last) {
+        std::memset(current.data(), 0, IMAGE_SIZE);
+        apply(current, entries[position].keyframe);
+    }
+    for (; position > target; --position) {
+        apply(current, entries[position].delta);
+    }
+
+    while (entries.size() > target + 1) {
+        used -= entry_size(entries.back());
+        entries.pop_back();
+    }
+    since_keyframe = 0;
+    for (size_t i = entries.size(); i-- > 0 && entries[i].keyframe.empty();) {
+        since_keyframe++;
+    }
+
+    bus.write_ram(0, current.data(), RAM_SIZE);
+    const uint8_t* tail = &current[RAM_SIZE];
+    CpuState registers;
+    registers.register_a = tail[0];
+    registers.register_x = tail[1];
+    registers.register_y = tail[2];
+    registers.status = tail[3];
+    registers.stack_pointer = tail[4];
+    registers.program_counter = static_cast<uint16_t>(tail[5] | (tail[6] << 8));
+    registers.running = tail[7] != 0;
+    cpu.set_state(registers);
+    return true;
+}
+
+void RewindBuffer::clear() {
+    entries.clear();
+    used = 0;
+    since_keyframe = 0;
+}
+
+size_t RewindBuffer::size() const {
+    return entries.size();
+}
+
+size_t RewindBuffer::memory_used() const {
+    return used;
+}
@@ -0,0 +1,54 @@
+#ifndef REWIND_BUFFER_HPP
+#define REWIND_BUFFER_HPP
+
+#include "Bus.hpp"
+#include "CPU.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#define DEFAULT_KEYFRAME_INTERVAL 60
+
+// Historique des tats de la machine (RAM du bus et registres), une entre par push().
+// Chaque entre garde le XOR avec l'tat prcdent, compress par plages de zros ; une entre sur
+// keyframe_interval garde aussi l'tat complet. Le XOR tant symtrique, on recule depuis l'tat courant
+// ou depuis la keyframe la plus proche : au plus keyframe_interval deltas appliqus par rewind().
+// Les entres les plus anciennes sont oublies au-del de memory_budget octets.
+class RewindBuffer {
+public:
+    explicit RewindBuffer(size_t memory_budget, size_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+    void push(const CPU& cpu, const Bus& bus);
+    // Restaure l'tat pouss frames entres avant le dernier (0 : le dernier) et oublie les suivants.
+    // false si l'historique est vide ; recule au plus jusqu' l'entre la plus ancienne.
+    bool rewind(CPU& cpu, Bus& bus, size_t frames = 0);
+    void clear();
+
+    size_t size() const;
+    size_t memory_used() const;
+
+private:
+    struct Entry {
+        std::vector<uint8_t> delta;    // XOR avec l'tat prcdent (avec des zros pour la premire entre)
+        std::vector<uint8_t> keyframe; // tat complet, ou vide
+    };
+
+    void capture(const CPU& cpu, const Bus& bus, std::vector<uint8_t>& image) const;
+    static std::vector<uint8_t> encode(const uint8_t* image, const uint8_t* previous);
+    static void apply(std::vector<uint8_t>& image, const std::vector<uint8_t>& delta);
+    static size_t entry_size(const Entry& entry);
+
+    size_t budget;
+    size_t interval;
+    size_t used;
+    size_t since_keyframe;
+    std::deque<Entry> entries;
+    // tat de la dernire entre : RAM puis registres
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> scratch;
+    std::vector<uint8_t> zeros;
+};
+
+#endif
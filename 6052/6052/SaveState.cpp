@@ -0,0 +1,281 @@
+#include "SaveState.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#define RAM_SIZE 0x10000
+#define PAGE_SIZE 0x100
+#define PAGE_COUNT (RAM_SIZE / PAGE_SIZE)
+
+// En-tte : magic (7) + version (1), drapeaux (1), registres (8), pages prsentes (32), tailles (4 + 4)
+#define HEADER_SIZE (8 + 1 + 8 + PAGE_COUNT / 8 + 8)
+#define FLAG_COMPRESSED 0x01
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 0xFFFF
+
+static uint32_t read_u32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Champs de l'en-tte en petit-boutiste, quel que soit l'hte
+static void write_u32_le(uint8_t* data, uint32_t value) {
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+    data[2] = static_cast<uint8_t>(value >> 16);
+    data[3] = static_cast<uint8_t>(value >> 24);
+}
+
+static uint32_t read_u32_le(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static void write_length(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 0xFF) {
+        out.push_back(0xFF);
+        length -= 0xFF;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+// Squences  la LZ4 : jeton (4 bits de littraux, 4 bits de correspondance - 4), littraux,
+// dcalage sur 16 bits, longueurs prolonges par octets de 255. La dernire squence n'a que des littraux.
+static std::vector<uint8_t> lz_compress(const uint8_t* src, size_t size) {
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 16);
+    std::array<uint32_t, 1 << LZ_HASH_BITS> table;
+    table.fill(UINT32_MAX);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = read_u32(src + pos);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        uint32_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(pos);
+
+        if (candidate == UINT32_MAX || pos - candidate > LZ_MAX_OFFSET || read_u32(src + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        size_t match = LZ_MIN_MATCH;
+        while (pos + match < size && src[candidate + match] == src[pos + match]) {
+            match++;
+        }
+
+        size_t literals = pos - anchor;
+        size_t token_pos = out.size();
+        out.push_back(0);
+        uint8_t literal_nibble = literals >= 15 ? 15 : static_cast<uint8_t>(literals);
+        uint8_t match_nibble = match - LZ_MIN_MATCH >= 15 ? 15 : static_cast<uint8_t>(match - LZ_MIN_MATCH);
+        out[token_pos] = static_cast<uint8_t>((literal_nibble << 4) | match_nibble);
+        if (literals >= 15) {
+            write_length(out, literals - 15);
+        }
+        out.insert(out.end(), src + anchor, src + pos);
+        uint16_t offset = static_cast<uint16_t>(pos - candidate);
+        out.push_back(static_cast<uint8_t>(offset));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+        if (match - LZ_MIN_MATCH >= 15) {
+            write_length(out, match - LZ_MIN_MATCH - 15);
+        }
+
+        pos += match;
+        anchor = pos;
+    }
+
+    size_t literals = size - anchor;
+    out.push_back(static_cast<uint8_t>((literals >= 15 ? 15 : literals) << 4));
+    if (literals >= 15) {
+        write_length(out, literals - 15);
+    }
+    out.insert(out.end(), src + anchor, src + size);
+    return out;
+}
+
+static bool read_length(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in >= end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 0xFF);
+    return true;
+}
+
+// Dcompresse exactement size octets dans dest, false si le flux est corrompu
+static bool lz_decompress(const uint8_t* in, size_t in_size, uint8_t* dest, size_t size) {
+    const uint8_t* end = in + in_size;
+    size_t pos = 0;
+
+    while (in < end) {
+        uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(in, end, literals)) {
+            return false;
+        }
+        if (literals > static_cast<size_t>(end - in) || literals > size - pos) {
+            return false;
+        }
+        std::memcpy(dest + pos, in, literals);
+        in += literals;
+        pos += literals;
+
+        if (in == end) {
+            break;
+        }
+        if (end - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        size_t match = (token & 0x0F);
+        if (match == 15 && !read_length(in, end, match)) {
+            return false;
+        }
+        match += LZ_MIN_MATCH;
+        if (offset == 0 || offset > pos || match > size - pos) {
+            return false;
+        }
+        // Les correspondances peuvent se recouvrir : copie octet par octet
+        for (size_t i = 0; i < match; ++i, ++pos) {
+            dest[pos] = dest[pos - offset];
+        }
+    }
+    return pos == size;
+}
+
+std::vector<uint8_t> save_state(const CPU& cpu, const Bus& bus, bool compress) {
+    std::vector<uint8_t> memory(RAM_SIZE);
+    bus.read_ram(0, memory.data(), memory.size());
+    const uint8_t* ram = memory.data();
+    CpuState registers = cpu.get_state();
+
+    std::vector<uint8_t> data(HEADER_SIZE, 0);
+    std::memcpy(data.data(), SAVE_STATE_MAGIC, 7);
+    data[7] = SAVE_STATE_VERSION;
+    data[8] = compress ? FLAG_COMPRESSED : 0;
+    data[9] = registers.register_a;
+    data[10] = registers.register_x;
+    data[11] = registers.register_y;
+    data[12] = registers.status;
+    data[13] = registers.stack_pointer;
+    data[14] = static_cast<uint8_t>(registers.program_counter);
+    data[15] = static_cast<uint8_t>(registers.program_counter >> 8);
+    data[16] = registers.running ? 1 : 0;
+
+    // Pages non nulles, concatnes
+    uint8_t* present = &data[17];
+    std::vector<uint8_t> pages;
+    pages.reserve(RAM_SIZE);
+    for (size_t page = 0; page < PAGE_COUNT; ++page) {
+        const uint8_t* content = ram + page * PAGE_SIZE;
+        bool zero = true;
+        for (size_t i = 0; i < PAGE_SIZE && zero; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, content + i, sizeof(word));
+            zero = word == 0;
+        }
+        if (!zero) {
+            present[page / 8] |= 1 << (page % 8);
+            pages.insert(pages.end(), content, content + PAGE_SIZE);
+        }
+    }
+
+    std::vector<uint8_t> compressed;
+    if (compress) {
+        compressed = lz_compress(pages.data(), pages.size());
+    }
+    const std::vector<uint8_t>& payload = compress ? compressed : pages;
+
+    write_u32_le(&data[17 + PAGE_COUNT / 8], static_cast<uint32_t>(pages.size()));
+    write_u32_le(&data[21 + PAGE_COUNT / 8], static_cast<uint32_t>(payload.size()));
+    data.insert(data.end(), payload.begin(), payload.end());
+    return data;
+}
+
+bool load_state(CPU& cpu, Bus& bus, const std::vector<uint8_t>& data) {
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), SAVE_STATE_MAGIC, 7) != 0) {
+        std::cerr << "Sauvegarde d'tat invalide" << std::endl;
+        return false;
+    }
+    if (data[7] != SAVE_STATE_VERSION) {
+        std::cerr << "Version de sauvegarde non prise en charge : " << static_cast<int>(data[7]) << std::endl;
+        return false;
+    }
+
+    const uint8_t* present = &data[17];
+    size_t page_count = 0;
+    for (size_t page = 0; page < PAGE_COUNT; ++page) {
+        page_count += (present[page / 8] >> (page % 8)) & 1;
+    }
+    uint32_t sizes[2] = { read_u32_le(&data[17 + PAGE_COUNT / 8]), read_u32_le(&data[21 + PAGE_COUNT / 8]) };
+    if (sizes[0] != page_count * PAGE_SIZE || sizes[1] != data.size() - HEADER_SIZE) {
+        std::cerr << "Sauvegarde d'tat tronque" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> decompressed;
+    const uint8_t* pages = &data[HEADER_SIZE];
+    if (data[8] & FLAG_COMPRESSED) {
+        decompressed.resize(sizes[0]);
+        if (!lz_decompress(pages, sizes[1], decompressed.data(), decompressed.size())) {
+            std::cerr << "Sauvegarde d'tat corrompue" << std::endl;
+            return false;
+        }
+        pages = decompressed.data();
+    }
+    else if (sizes[1] != sizes[0]) {
+        std::cerr << "Sauvegarde d'tat tronque" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> ram(RAM_SIZE, 0);
+    for (size_t page = 0; page < PAGE_COUNT; ++page) {
+        if ((present[page / 8] >> (page % 8)) & 1) {
+            std::memcpy(&ram[page * PAGE_SIZE], pages, PAGE_SIZE);
+            pages += PAGE_SIZE;
+        }
+    }
+    bus.write_ram(0, ram.data(), ram.size());
+
+    CpuState registers;
+    registers.register_a = data[9];
+    registers.register_x = data[10];
+    registers.register_y = data[11];
+    registers.status = data[12];
+    registers.stack_pointer = data[13];
+    registers.program_counter = static_cast<uint16_t>(data[14] | (data[15] << 8));
+    registers.running = data[16] != 0;
+    cpu.set_state(registers);
+    return true;
+}
+
+bool save_state_file(const std::string& path, const CPU& cpu, const Bus& bus, bool compress) {
+    std::vector<uint8_t> data = save_state(cpu, bus, compress);
+    std::ofstream file(path, std::ios::binary);
+    if (!file || !file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+        std::cerr << "Impossible d'crire la sauvegarde " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool load_state_file(const std::string& path, CPU& cpu, Bus& bus) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossible d'ouvrir la sauvegarde " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return load_state(cpu, bus, data);
+}
@@ -0,0 +1,24 @@
+#ifndef SAVE_STATE_HPP
+#define SAVE_STATE_HPP
+
+#include "Bus.hpp"
+#include "CPU.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SAVE_STATE_MAGIC "6502SAV"
+#define SAVE_STATE_VERSION 1
+
+// tat complet de la machine : registres du CPU et RAM du bus, cran et touche compris.
+// La graine et l'tat du gnrateur de $FE appartiennent  l'hte et ne sont pas sauvegards.
+// Les pages entirement nulles ne sont pas stockes ; les autres peuvent tre compresses (LZ77  la LZ4).
+std::vector<uint8_t> save_state(const CPU& cpu, const Bus& bus, bool compress = false);
+// Laisse la machine intacte si data n'est pas une sauvegarde valide de cette version
+bool load_state(CPU& cpu, Bus& bus, const std::vector<uint8_t>& data);
+
+bool save_state_file(const std::string& path, const CPU& cpu, const Bus& bus, bool compress = false);
+bool load_state_file(const std::string& path, CPU& cpu, Bus& bus);
+
+#endif
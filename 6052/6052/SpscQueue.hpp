@@ -0,0 +1,45 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// File circulaire sans verrou pour un seul producteur et un seul consommateur.
+// Capacity doit tre une puissance de deux ; la file contient au plus Capacity lments.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity doit tre une puissance de deux");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producteur : false si la file est pleine
+    bool push(const T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[position & (Capacity - 1)] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consommateur : false si la file est vide
+    bool pop(T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = items[position & (Capacity - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> items;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif
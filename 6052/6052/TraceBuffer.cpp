@@ -0,0 +1,82 @@
+#include "TraceBuffer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Au plus 7 cycles par instruction : l'cart entre le plus ancien et le plus rcent enregistrement tient sur 32 bits
+#define MAX_TRACE_CAPACITY (static_cast<size_t>(1) << 28)
+
+TraceBuffer::TraceBuffer(size_t capacity) : cycle(0), written_count(0) {
+    size_t rounded = 1;
+    while (rounded < capacity && rounded < MAX_TRACE_CAPACITY) {
+        rounded <<= 1;
+    }
+    if (capacity > MAX_TRACE_CAPACITY) {
+        std::cerr << "Capacit de trace limite  " << MAX_TRACE_CAPACITY << " instructions" << std::endl;
+    }
+    records.resize(rounded);
+    mask = rounded - 1;
+}
+
+void TraceBuffer::clear() {
+    written_count.store(0, std::memory_order_release);
+    cycle = 0;
+}
+
+void TraceBuffer::set_cycle(uint64_t value) {
+    cycle = value;
+}
+
+size_t TraceBuffer::capacity() const {
+    return records.size();
+}
+
+uint64_t TraceBuffer::written() const {
+    return written_count.load(std::memory_order_acquire);
+}
+
+size_t TraceBuffer::size() const {
+    uint64_t count = written();
+    return count < records.size() ? static_cast<size_t>(count) : records.size();
+}
+
+const TraceRecord& TraceBuffer::at(size_t i) const {
+    uint64_t count = written();
+    uint64_t oldest = count - size();
+    return records[(oldest + i) & mask];
+}
+
+bool TraceBuffer::save(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Impossible d'ouvrir " << path << std::endl;
+        return false;
+    }
+
+    TraceFileHeader header = {};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.record_size = sizeof(TraceRecord);
+    header.record_count = size();
+    if (header.record_count != 0) {
+        uint32_t span = static_cast<uint32_t>(cycle) - at(0).cycle;
+        header.first_cycle = cycle - span;
+    }
+
+    // Le plus ancien enregistrement n'est pas forcment en tte du tableau : deux critures au plus
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t start = (written() - header.record_count) & mask;
+    size_t first_part = records.size() - static_cast<size_t>(start);
+    if (first_part > header.record_count) {
+        first_part = static_cast<size_t>(header.record_count);
+    }
+    ok = ok && std::fwrite(&records[start], sizeof(TraceRecord), first_part, file) == first_part;
+    size_t second_part = static_cast<size_t>(header.record_count) - first_part;
+    ok = ok && std::fwrite(records.data(), sizeof(TraceRecord), second_part, file) == second_part;
+
+    if (std::fclose(file) != 0 || !ok) {
+        std::cerr << "chec de l'criture de la trace " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef TRACE_BUFFER_HPP
+#define TRACE_BUFFER_HPP
+
+#include "CPU.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define TRACE_MAGIC "6502TRC1"
+
+// Un enregistrement de 16 octets par instruction, registres avant son excution
+struct TraceRecord {
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operand_lo;
+    uint8_t operand_hi;
+    uint8_t register_a;
+    uint8_t register_x;
+    uint8_t register_y;
+    uint8_t status;
+    uint8_t stack_pointer;
+    uint16_t reserved;
+    uint32_t cycle; // 32 bits de poids faible du compteur de cycles, reconstitu au dcodage
+};
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord doit faire 16 octets");
+
+// En-tte du fichier crit par save(), suivi de record_count TraceRecord dans l'ordre chronologique
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t record_count;
+    uint64_t first_cycle;
+};
+
+// Trace circulaire en mmoire : seules les capacity dernires instructions sont conserves.
+// S'utilise comme hook (cpu.run_with_callback(trace, cycles)), sans aucune E/S pendant l'excution.
+// Un seul thread crit ; written() peut tre lu depuis un autre thread.
+class TraceBuffer {
+public:
+    static constexpr uint8_t hook_mask = HOOK_EXECUTE;
+
+    // capacity est arrondie  la puissance de deux suprieure
+    explicit TraceBuffer(size_t capacity);
+
+    void on_execute(const CPU& cpu, const DecodedInstruction& instruction) {
+        uint64_t index = written_count.load(std::memory_order_relaxed);
+        TraceRecord& record = records[index & mask];
+        record.pc = instruction.address;
+        record.opcode = instruction.code;
+        record.operand_lo = static_cast<uint8_t>(instruction.operand);
+        record.operand_hi = static_cast<uint8_t>(instruction.operand >> 8);
+        record.register_a = cpu.register_a;
+        record.register_x = cpu.register_x;
+        record.register_y = cpu.register_y;
+        record.status = cpu.status;
+        record.stack_pointer = cpu.stack_pointer;
+        record.reserved = 0;
+        record.cycle = static_cast<uint32_t>(cycle);
+        cycle += instruction.cycles;
+        written_count.store(index + 1, std::memory_order_release);
+    }
+
+    void clear();
+    // Cycle attribu  la prochaine instruction trace
+    void set_cycle(uint64_t value);
+
+    size_t capacity() const;
+    uint64_t written() const;
+    // Nombre d'enregistrements encore prsents (au plus capacity())
+    size_t size() const;
+    // i = 0 pour le plus ancien enregistrement conserv
+    const TraceRecord& at(size_t i) const;
+
+    bool save(const std::string& path) const;
+
+private:
+    std::vector<TraceRecord> records;
+    uint64_t mask;
+    uint64_t cycle;
+    std::atomic<uint64_t> written_count;
+};
+
+#endif
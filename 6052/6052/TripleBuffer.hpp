@@ -0,0 +1,52 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Trois tampons pour un seul producteur et un seul consommateur, sans verrou.
+// Le producteur remplit back() puis publish() ; le consommateur appelle update()
+// et lit front(). Aucun des deux n'attend l'autre : une trame publie puis
+// remplace avant d'tre lue est simplement perdue.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), back_index(0), front_index(2) {}
+
+    // Producteur
+    T& back() {
+        return buffers[back_index];
+    }
+
+    void publish() {
+        uint8_t previous = middle.exchange(back_index | FRESH_BIT, std::memory_order_acq_rel);
+        back_index = previous & INDEX_MASK;
+    }
+
+    // Consommateur : true si un tampon plus rcent que front() a t rcupr
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT)) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(front_index, std::memory_order_acq_rel);
+        front_index = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& front() const {
+        return buffers[front_index];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH_BIT = 0x04;
+
+    std::array<T, 3> buffers;
+    // Indice du tampon du milieu, et FRESH_BIT s'il n'a pas encore t lu
+    std::atomic<uint8_t> middle;
+    alignas(64) uint8_t back_index;
+    alignas(64) uint8_t front_index;
+};
+
+#endif
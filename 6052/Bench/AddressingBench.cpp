@@ -0,0 +1,98 @@
+// Cot par mode d'adressage : 64 copies d'une mme instruction dans une boucle JMP, meilleur de 3 passes
+// g++ -O2 -std=c++17 -falign-functions=64 -I../6052 AddressingBench.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/OpCodes.cpp -o addressing_bench
+// ./addressing_bench [cycles par passe]
+// N'utilise que load, reset et run : compil contre le 6052/ d'une version plus ancienne (sans BlockCache.cpp avant le
+// cache de blocs), il donne les chiffres avant/aprs d'un changement. L'alignement des fonctions gomme l'effet de placement
+#include "CPU.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define DEFAULT_CYCLES 20000000
+#define RUNS 3
+#define COPIES 64
+#define JMP_CYCLES 3
+// Le corps de boucle commence sur sa propre page :  partir de la version  cache de blocs, il tient en un seul bloc
+#define LOOP_START 0x0700
+// Le pointeur des modes indirects, en $10/$11, dsigne DATA_ADDR ; X = Y = 0 : jamais de franchissement de page
+#define DATA_ADDR 0x0300
+// Adresse de chargement de CPU::load, que les anciennes versions n'exportaient pas (PROGRAM_START)
+#define LOAD_ADDR 0x0600
+
+struct Mode {
+    const char* name;
+    std::vector<uint8_t> instruction;
+    int cycles;
+};
+
+// Prologue qui pose le pointeur indirect, puis haut: JMP corps ; corps: 64 x instruction ; JMP haut.
+// Le saut intermdiaire empche de reconnatre une boucle d'attente, que run sauterait sans l'excuter
+static std::vector<uint8_t> build_program(const Mode& mode) {
+    std::vector<uint8_t> program = {
+        0xA9, DATA_ADDR & 0xFF, 0x85, 0x10,   // LDA #<DATA_ADDR ; STA $10
+        0xA9, DATA_ADDR >> 8, 0x85, 0x11,     // LDA #>DATA_ADDR ; STA $11, laisse Z  0 pour BEQ
+    };
+    uint16_t top = static_cast<uint16_t>(LOAD_ADDR + program.size());
+    program.insert(program.end(), { 0x4C, LOOP_START & 0xFF, LOOP_START >> 8 });
+    program.resize(LOOP_START - LOAD_ADDR, 0xEA);
+    for (int i = 0; i < COPIES; ++i) {
+        program.insert(program.end(), mode.instruction.begin(), mode.instruction.end());
+    }
+    program.insert(program.end(), { 0x4C, static_cast<uint8_t>(top & 0xFF), static_cast<uint8_t>(top >> 8) });
+    return program;
+}
+
+// ns par instruction mule ; le nombre d'instructions se dduit des cycles, toutes les instructions tant  cot fixe
+static double measure(const Mode& mode, int cycles) {
+    std::vector<uint8_t> program = build_program(mode);
+    int loop_cycles = COPIES * mode.cycles + 2 * JMP_CYCLES;
+    double instructions = static_cast<double>(cycles) * (COPIES + 2) / loop_cycles;
+
+    double best = 0;
+    for (int run = 0; run < RUNS; ++run) {
+        Bus bus;
+        CPU cpu(bus);
+        cpu.load(program);
+        cpu.reset();
+        auto start = std::chrono::steady_clock::now();
+        cpu.run(cycles);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!cpu.is_cpu_running()) {
+            std::fprintf(stderr, "%s : le programme s'est arrt\n", mode.name);
+            std::exit(1);
+        }
+        best = run == 0 ? seconds : std::min(best, seconds);
+    }
+    return best * 1e9 / instructions;
+}
+
+int main(int argc, char** argv) {
+    int cycles = argc > 1 ? std::atoi(argv[1]) : DEFAULT_CYCLES;
+    if (cycles <= 0) {
+        std::fprintf(stderr, "Usage : addressing_bench [cycles par passe]\n");
+        return 1;
+    }
+
+    const Mode modes[] = {
+        { "Implied INX", { 0xE8 }, 2 },
+        { "Accumulator ASL", { 0x0A }, 2 },
+        { "Immediate LDA", { 0xA9, 0x01 }, 2 },
+        { "ZeroPage LDA", { 0xA5, 0x10 }, 3 },
+        { "ZeroPage_X LDA", { 0xB5, 0x10 }, 4 },
+        { "ZeroPage_Y LDX", { 0xB6, 0x10 }, 4 },
+        // Non pris : un branchement pris cote un cycle de plus, que les anciennes versions ne comptaient pas
+        { "Relative BEQ", { 0xF0, 0x00 }, 2 },
+        { "Absolute LDA", { 0xAD, DATA_ADDR & 0xFF, DATA_ADDR >> 8 }, 4 },
+        { "Absolute_X LDA", { 0xBD, DATA_ADDR & 0xFF, DATA_ADDR >> 8 }, 4 },
+        { "Absolute_Y LDA", { 0xB9, DATA_ADDR & 0xFF, DATA_ADDR >> 8 }, 4 },
+        { "Indirect_X LDA", { 0xA1, 0x10 }, 6 },
+        { "Indirect_Y LDA", { 0xB1, 0x10 }, 5 },
+    };
+    for (const Mode& mode : modes) {
+        std::printf("%-16s : %6.2f ns par instruction mule\n", mode.name, measure(mode, cycles));
+    }
+    return 0;
+}
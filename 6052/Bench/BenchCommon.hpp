@@ -0,0 +1,48 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+// Compil contre une version antrieure  Machine.hpp (voir DispatchBench.cpp), seul le chemin commun existe
+#ifndef BASELINE_API
+#include "Machine.hpp"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Rglages et outils communs aux mesures qui jouent Snake et Animation trame par trame, comme 6052.cpp
+
+#define DEFAULT_GAMES 20
+#define FRAME_CYCLES 60
+// Une partie de Snake s'arrte avant, sur son BRK
+#define GAME_FRAMES 20000
+// Le serpent tourne toutes les KEY_FRAMES trames, assez tt pour ne pas heurter le bord
+#define KEY_FRAMES 100
+
+inline uint8_t key_for(int frame) {
+    static const uint8_t KEYS[] = { 'd', 's', 'a', 'w' };
+    return KEYS[(frame / KEY_FRAMES) % 4];
+}
+
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#ifndef BASELINE_API
+// Empreinte calcule en fin de partie seulement : tenue  jour pendant la mesure, elle ralentirait les critures
+inline uint64_t final_hash(Machine& machine) {
+    machine.bus.enable_ram_hash();
+    return machine.cpu.state_hash();
+}
+#endif
+
+// Empreinte d'une srie de parties, sensible  leur ordre
+inline uint64_t combine_hashes(const std::vector<uint64_t>& hashes) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        hash ^= hashes[i] * (i + 1);
+    }
+    return hash;
+}
+
+#endif
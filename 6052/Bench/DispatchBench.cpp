@@ -0,0 +1,248 @@
+// Instructions hte par instruction mule sur Snake et Animation, par trames de 60 cycles comme 6052.cpp :
+// CPU::run (cache de blocs, boucles d'attente sautes) et CPU::step (une instruction par appel, sans cache)
+// g++ -O2 -std=c++17 -I../6052 DispatchBench.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/Devices.cpp ../6052/Machine.cpp ../6052/OpCodes.cpp -o dispatch_bench
+// ./dispatch_bench [parties]
+// Les instructions hte viennent du compteur matriel de Linux (perf_event_open) ; sans lui, seul le temps est affich
+//
+// Le chemin commun n'utilise que Bus, CPU, load, reset, run et run_with_callback, et crit $FE et $FF en mmoire comme
+// l'ancien 6052.cpp. Compil contre le 6052/ du commit de dpart (eaad797, OPCODES_MAP et switch), il donne la rfrence
+// du cot de dispatch ; -I../6052 n'y sert qu' Programs.hpp :
+// g++ -O2 -std=c++17 -DBASELINE_API -I<ancien>/6052/6052 -I../6052 DispatchBench.cpp <ancien>/6052/6052/Bus.cpp <ancien>/6052/6052/CPU.cpp <ancien>/6052/6052/OpCodes.cpp -o dispatch_baseline
+// Les anciennes versions s'arrtent  l'instruction prs et les nouvelles au bloc prs : les parties ne sont pas
+// identiques d'une version  l'autre, d'o des cots par trame et par instruction plutt qu'une empreinte commune
+#include "BenchCommon.hpp"
+#include "CPU.hpp"
+#include "Programs.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Instructions utilisateur excutes par ce thread, si le noyau expose le compteur
+class InstructionCounter {
+public:
+    InstructionCounter() : fd(-1) {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~InstructionCounter() {
+#if defined(__linux__)
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    bool available() const {
+        return fd >= 0;
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t stop() {
+        uint64_t count = 0;
+#if defined(__linux__)
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd;
+};
+
+struct Measure {
+    uint64_t host_instructions = 0;
+    double seconds = 0;
+};
+
+// Tirage de $FE du chemin commun, les anciennes versions n'ayant pas de RandomDevice
+static uint8_t next_random(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<uint8_t>((state >> 16) % 16 + 1);
+}
+
+// Une partie sur un Bus et un CPU nus, par run ou, si counting, par run_with_callback qui compte les instructions mules
+static uint64_t play_portable(const std::vector<uint8_t>& program, uint32_t seed, bool counting, uint64_t& frames,
+    InstructionCounter& counter, Measure& measure) {
+    Bus bus;
+    CPU cpu(bus);
+    cpu.load(program);
+    cpu.reset();
+    uint32_t random = seed;
+    uint64_t instructions = 0;
+    auto start = std::chrono::steady_clock::now();
+    counter.start();
+    for (int frame = 0; frame < GAME_FRAMES && cpu.is_cpu_running(); ++frame) {
+        cpu.mem_write(0xFE, next_random(random));
+        cpu.mem_write(0xFF, key_for(frame));
+        if (counting) {
+            cpu.run_with_callback([&instructions](CPU&) { ++instructions; }, FRAME_CYCLES);
+#ifdef BASELINE_API
+            // L'ancienne boucle ne rappelait pas le callback aprs l'instruction qui puisait le budget
+            if (cpu.is_cpu_running()) {
+                ++instructions;
+            }
+#endif
+        }
+        else {
+            cpu.run(FRAME_CYCLES);
+        }
+        ++frames;
+    }
+    measure.host_instructions += counter.stop();
+    measure.seconds += seconds_since(start);
+    return instructions;
+}
+
+static void bench_portable(const char* name, const std::vector<uint8_t>& program, int games, InstructionCounter& counter) {
+    Measure run;
+    Measure hooked;
+    uint64_t frames = 0;
+    uint64_t hooked_frames = 0;
+    uint64_t instructions = 0;
+    for (int game = 0; game < games; ++game) {
+        uint32_t seed = static_cast<uint32_t>(game + 1);
+        play_portable(program, seed, false, frames, counter, run);
+        instructions += play_portable(program, seed, true, hooked_frames, counter, hooked);
+    }
+
+    std::printf("%-9s : chemin commun, %llu trames, %llu instructions mules par run_with_callback\n", name,
+        static_cast<unsigned long long>(frames), static_cast<unsigned long long>(instructions));
+    if (counter.available()) {
+        std::printf("  run               : %8.1f instructions hte par trame, %7.1f ns\n",
+            static_cast<double>(run.host_instructions) / frames, run.seconds * 1e9 / frames);
+        std::printf("  run_with_callback : %8.1f instructions hte par instruction mule, %5.2f ns\n",
+            static_cast<double>(hooked.host_instructions) / instructions, hooked.seconds * 1e9 / instructions);
+    }
+    else {
+        std::printf("  run               : %7.1f ns par trame\n", run.seconds * 1e9 / frames);
+        std::printf("  run_with_callback : %5.2f ns par instruction mule\n", hooked.seconds * 1e9 / instructions);
+    }
+}
+
+#ifndef BASELINE_API
+// Une partie par CPU::run, trame par trame ; frame_ends reoit le cycle de fin de chaque trame
+static void play_run(Machine& machine, std::vector<uint64_t>& frame_ends, InstructionCounter& counter, Measure& measure) {
+    uint64_t cycles = 0;
+    frame_ends.clear();
+    auto start = std::chrono::steady_clock::now();
+    counter.start();
+    for (int frame = 0; frame < GAME_FRAMES && machine.cpu.is_cpu_running(); ++frame) {
+        machine.keyboard.press(key_for(frame));
+        cycles += machine.cpu.run(FRAME_CYCLES);
+        frame_ends.push_back(cycles);
+    }
+    measure.host_instructions += counter.stop();
+    measure.seconds += seconds_since(start);
+}
+
+// La mme partie instruction par instruction, touches donnes aux mmes cycles ; renvoie les instructions mules
+static uint64_t play_step(Machine& machine, const std::vector<uint64_t>& frame_ends, InstructionCounter& counter, Measure& measure) {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    auto start = std::chrono::steady_clock::now();
+    counter.start();
+    for (size_t frame = 0; frame < frame_ends.size(); ++frame) {
+        machine.keyboard.press(key_for(static_cast<int>(frame)));
+        while (cycles < frame_ends[frame] && machine.cpu.is_cpu_running()) {
+            cycles += machine.cpu.step();
+            ++instructions;
+        }
+    }
+    measure.host_instructions += counter.stop();
+    measure.seconds += seconds_since(start);
+    return instructions;
+}
+
+static bool bench(const char* name, const std::vector<uint8_t>& program, int games, InstructionCounter& counter) {
+    ProgramImage image(program, PROGRAM_START);
+    Measure run;
+    Measure step;
+    uint64_t instructions = 0;
+    std::vector<uint64_t> hashes;
+    std::vector<uint64_t> frame_ends;
+    for (int game = 0; game < games; ++game) {
+        uint32_t seed = static_cast<uint32_t>(game + 1);
+        Machine by_run(image, seed);
+        Machine by_step(image, seed);
+        play_run(by_run, frame_ends, counter, run);
+        instructions += play_step(by_step, frame_ends, counter, step);
+
+        uint64_t run_hash = final_hash(by_run);
+        if (run_hash != final_hash(by_step)) {
+            std::printf("%s, partie %d : CPU::run et CPU::step divergent\n", name, game);
+            return false;
+        }
+        hashes.push_back(run_hash);
+    }
+
+    std::printf("%-9s : %llu instructions mules, empreinte %016llx\n", name, static_cast<unsigned long long>(instructions),
+        static_cast<unsigned long long>(combine_hashes(hashes)));
+    const char* labels[] = { "CPU::run ", "CPU::step" };
+    const Measure* measures[] = { &run, &step };
+    for (int i = 0; i < 2; ++i) {
+        if (counter.available()) {
+            std::printf("  %s : %6.1f instructions hte par instruction mule, %5.2f ns\n", labels[i],
+                static_cast<double>(measures[i]->host_instructions) / instructions, measures[i]->seconds * 1e9 / instructions);
+        }
+        else {
+            std::printf("  %s : %5.2f ns par instruction mule\n", labels[i], measures[i]->seconds * 1e9 / instructions);
+        }
+    }
+    return true;
+}
+#endif
+
+int main(int argc, char** argv) {
+    int games = argc > 1 ? std::atoi(argv[1]) : DEFAULT_GAMES;
+    if (games <= 0) {
+        std::fprintf(stderr, "Usage : dispatch_bench [parties]\n");
+        return 1;
+    }
+
+    InstructionCounter counter;
+    if (!counter.available()) {
+        std::printf("Compteur d'instructions indisponible (perf_event_open) : temps seulement\n");
+    }
+    bench_portable("snake", SNAKE_PROGRAM, games, counter);
+    bench_portable("animation", ANIMATION_PROGRAM, games, counter);
+#ifdef BASELINE_API
+    return 0;
+#else
+    bool same = bench("snake", SNAKE_PROGRAM, games, counter);
+    same = bench("animation", ANIMATION_PROGRAM, games, counter) && same;
+    return same ? 0 : 1;
+#endif
+}
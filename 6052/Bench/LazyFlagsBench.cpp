@@ -0,0 +1,82 @@
+// Drapeaux N/Z/C/V paresseux ou calculs  chaque instruction, sur Snake et Animation
+// g++ -O2 -std=c++17 -DLAZY_FLAGS=0 -I../6052 LazyFlagsBench.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/Devices.cpp ../6052/Machine.cpp ../6052/OpCodes.cpp -o flags_eager
+// g++ -O2 -std=c++17 -DLAZY_FLAGS=1 -I../6052 LazyFlagsBench.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/Devices.cpp ../6052/Machine.cpp ../6052/OpCodes.cpp -o flags_lazy
+// ./flags_eager [parties] ; ./flags_lazy [parties]
+// Les deux versions doivent finir dans les mmes tats : diff <(./flags_eager --hashes) <(./flags_lazy --hashes)
+#include "BenchCommon.hpp"
+#include "Programs.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Animation d'un seul tenant, sans rendre la main entre les trames
+#define LONG_RUN_CYCLES 200000000
+
+struct Result {
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    double seconds = 0;
+    std::vector<uint64_t> hashes;
+};
+
+// Parties trame par trame, comme 6052.cpp
+static Result play_frames(const std::vector<uint8_t>& program, int games) {
+    ProgramImage image(program, PROGRAM_START);
+    Result result;
+    for (int game = 0; game < games; ++game) {
+        Machine machine(image, static_cast<uint32_t>(game + 1));
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < GAME_FRAMES && machine.cpu.is_cpu_running(); ++frame) {
+            machine.keyboard.press(key_for(frame));
+            result.cycles += machine.cpu.run(FRAME_CYCLES);
+            ++result.frames;
+        }
+        result.seconds += seconds_since(start);
+        result.hashes.push_back(final_hash(machine));
+    }
+    return result;
+}
+
+static Result play_long(const std::vector<uint8_t>& program) {
+    Machine machine(ProgramImage(program, PROGRAM_START), 1);
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    result.cycles = machine.cpu.run(LONG_RUN_CYCLES);
+    result.seconds = seconds_since(start);
+    result.hashes.push_back(final_hash(machine));
+    return result;
+}
+
+int main(int argc, char** argv) {
+    bool hashes_only = argc > 1 && std::strcmp(argv[1], "--hashes") == 0;
+    int games = argc > 1 && !hashes_only ? std::atoi(argv[1]) : DEFAULT_GAMES;
+    if (games <= 0) {
+        std::fprintf(stderr, "Usage : flags_bench [parties | --hashes]\n");
+        return 1;
+    }
+
+    Result snake = play_frames(SNAKE_PROGRAM, games);
+    Result animation = play_frames(ANIMATION_PROGRAM, games);
+    Result long_run = play_long(ANIMATION_PROGRAM);
+
+    if (hashes_only) {
+        for (const Result* result : { &snake, &animation, &long_run }) {
+            for (uint64_t hash : result->hashes) {
+                std::printf("%016llx\n", static_cast<unsigned long long>(hash));
+            }
+        }
+        return 0;
+    }
+
+    std::printf("LAZY_FLAGS=%d\n", LAZY_FLAGS);
+    std::printf("snake, trames de %d cycles     : %7.1f ns par trame, empreinte %016llx\n", FRAME_CYCLES,
+        snake.seconds * 1e9 / snake.frames, static_cast<unsigned long long>(combine_hashes(snake.hashes)));
+    std::printf("animation, trames de %d cycles : %7.1f ns par trame, empreinte %016llx\n", FRAME_CYCLES,
+        animation.seconds * 1e9 / animation.frames, static_cast<unsigned long long>(combine_hashes(animation.hashes)));
+    std::printf("animation d'un seul tenant     : %7.2f ns par cycle, empreinte %016llx\n",
+        long_run.seconds * 1e9 / long_run.cycles, static_cast<unsigned long long>(long_run.hashes[0]));
+    return 0;
+}
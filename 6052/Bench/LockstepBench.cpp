@@ -0,0 +1,128 @@
+// Mesure de Lockstep face  autant de boucles CPU::run indpendantes
+// g++ -O2 -std=c++17 -I../6052 LockstepBench.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/Devices.cpp ../6052/Lockstep.cpp ../6052/Machine.cpp ../6052/OpCodes.cpp -o lockstep_bench
+// ./lockstep_bench [instances] [snake|animation] [cycles par instance]
+#include "BenchCommon.hpp"
+#include "Lockstep.hpp"
+#include "Programs.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define DEFAULT_LANES 64
+#define DEFAULT_CYCLES 2000000
+// Une touche par instance et par tranche, comme un agent qui joue une action par trame
+#define SLICE_CYCLES 20000
+
+// Touche de l'instance lane pour la tranche slice, identique pour tous les moteurs
+static uint8_t lane_key(size_t lane, int slice) {
+    static const uint8_t KEYS[] = { 'w', 'a', 's', 'd' };
+    uint32_t hash = static_cast<uint32_t>(lane) * 2654435761u ^ static_cast<uint32_t>(slice) * 40503u;
+    return KEYS[(hash >> 13) & 3];
+}
+
+int main(int argc, char** argv) {
+    size_t lanes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : DEFAULT_LANES;
+    std::string name = argc > 2 ? argv[2] : "snake";
+    long cycles = argc > 3 ? std::strtol(argv[3], nullptr, 10) : DEFAULT_CYCLES;
+    if (lanes == 0 || cycles <= 0 || (name != "snake" && name != "animation")) {
+        std::fprintf(stderr, "Usage : lockstep_bench [instances] [snake|animation] [cycles par instance]\n");
+        return 1;
+    }
+    const std::vector<uint8_t>& program = name == "snake" ? SNAKE_PROGRAM : ANIMATION_PROGRAM;
+    int slices = static_cast<int>((cycles + SLICE_CYCLES - 1) / SLICE_CYCLES);
+
+    std::vector<uint32_t> seeds(lanes);
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        seeds[lane] = static_cast<uint32_t>(lane + 1);
+    }
+
+    // Rfrence : une machine et une boucle CPU::run par instance, boucles d'attente sautes comprises
+    ProgramImage image(program, PROGRAM_START);
+    std::vector<std::unique_ptr<Machine>> machines;
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        machines.push_back(std::make_unique<Machine>(image, seeds[lane]));
+    }
+    uint64_t scalar_cycles = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int slice = 0; slice < slices; ++slice) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            Machine& machine = *machines[lane];
+            if (machine.cpu.is_cpu_running()) {
+                machine.keyboard.press(lane_key(lane, slice));
+                scalar_cycles += machine.cpu.run(SLICE_CYCLES);
+            }
+        }
+    }
+    double scalar_seconds = seconds_since(start);
+    std::printf("%zu instances de %s, %ld cycles chacune\n", lanes, name.c_str(), cycles);
+    std::printf("CPU::run   : %8.1f MHz cumuls\n", scalar_cycles / scalar_seconds / 1e6);
+
+    // Contrat de Lockstep : chaque instance se comporte comme CPU::step en boucle jusqu' puiser sa tranche
+    std::vector<std::unique_ptr<Machine>> stepped;
+    std::vector<uint64_t> stepped_cycles(lanes, 0);
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        stepped.push_back(std::make_unique<Machine>(image, seeds[lane]));
+    }
+    for (int slice = 0; slice < slices; ++slice) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            Machine& machine = *stepped[lane];
+            if (!machine.cpu.is_cpu_running()) {
+                continue;
+            }
+            machine.keyboard.press(lane_key(lane, slice));
+            int spent = 0;
+            while (spent < SLICE_CYCLES && machine.cpu.is_cpu_running()) {
+                spent += machine.cpu.step();
+            }
+            stepped_cycles[lane] += spent;
+        }
+    }
+
+    const char* names[] = { "scalaire", "AVX2", "AVX-512" };
+    int best = static_cast<int>(lockstep_kernel());
+    for (int kernel = 0; kernel <= best; ++kernel) {
+        auto engine = std::make_unique<Lockstep>(program, seeds, static_cast<LockstepKernel>(kernel));
+        start = std::chrono::steady_clock::now();
+        for (int slice = 0; slice < slices; ++slice) {
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                if (engine->state(lane).running) {
+                    engine->keyboard(lane).press(lane_key(lane, slice));
+                }
+            }
+            engine->run(SLICE_CYCLES);
+        }
+        double seconds = seconds_since(start);
+
+        uint64_t total = 0;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            total += engine->cycles(lane);
+        }
+        uint64_t vector = engine->vector_instructions();
+        uint64_t executed = vector + engine->scalar_instructions();
+        uint64_t steps = engine->vector_steps();
+        std::printf("%-10s : %8.1f MHz cumuls, %5.1f %% des instructions de front, %4.1f voies par pas\n", names[kernel],
+            total / seconds / 1e6, executed ? 100.0 * vector / executed : 0.0, steps ? static_cast<double>(vector) / steps : 0.0);
+
+        std::vector<uint8_t> expected_ram(0x10000), ram(0x10000);
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            stepped[lane]->bus.read_ram(0, expected_ram.data(), expected_ram.size());
+            engine->bus(lane).read_ram(0, ram.data(), ram.size());
+            CpuState expected = stepped[lane]->cpu.get_state();
+            CpuState state = engine->state(lane);
+            bool same = expected.register_a == state.register_a && expected.register_x == state.register_x &&
+                expected.register_y == state.register_y && expected.status == state.status &&
+                expected.stack_pointer == state.stack_pointer && expected.program_counter == state.program_counter &&
+                expected.running == state.running && stepped_cycles[lane] == engine->cycles(lane) &&
+                expected_ram == ram;
+            if (!same) {
+                std::printf("Noyau %s : instance %zu diffrente de CPU::step en boucle\n", names[kernel], lane);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
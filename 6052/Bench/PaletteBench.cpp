@@ -0,0 +1,91 @@
+// Mesure de la conversion de l'cran 32x32 en texels RGBA
+// g++ -O2 -std=c++17 -I../6052 PaletteBench.cpp ../6052/Color.cpp -o palette_bench
+#include "Color.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define WIDTH 32
+#define HEIGHT 32
+#define ITERATIONS 200000
+
+// Ancien chemin : color() vers un tampon RGB intermdiaire, puis RGB vers RGBA comme l'ancien Renderer::RenderFrame
+static void legacy_path(const std::vector<uint8_t>& pixels, std::vector<uint8_t>& frame, uint8_t* texels, size_t row_pitch) {
+    size_t frame_idx = 0;
+    for (uint8_t color_idx : pixels) {
+        Color col = color(color_idx);
+        if (frame[frame_idx] != col.r || frame[frame_idx + 1] != col.g || frame[frame_idx + 2] != col.b) {
+            frame[frame_idx] = col.r;
+            frame[frame_idx + 1] = col.g;
+            frame[frame_idx + 2] = col.b;
+        }
+        frame_idx += 3;
+    }
+
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            int index = (y * WIDTH + x) * 3;
+            size_t texel_index = y * row_pitch + x * 4;
+            texels[texel_index] = frame[index];
+            texels[texel_index + 1] = frame[index + 1];
+            texels[texel_index + 2] = frame[index + 2];
+            texels[texel_index + 3] = 255;
+        }
+    }
+}
+
+template <typename Convert>
+static double measure(std::vector<std::vector<uint8_t>>& screens, Convert convert) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        convert(screens[i % screens.size()]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+int main() {
+    const char* names[] = { "scalaire", "SSSE3", "AVX2" };
+    const size_t row_pitch = 256; // Pas de ligne d'une texture mappe, plus large que la ligne elle-mme
+
+    // Quelques crans alatoires, dont des octets hors palette
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> screens(8, std::vector<uint8_t>(WIDTH * HEIGHT));
+    for (auto& screen : screens) {
+        for (uint8_t& pixel : screen) {
+            pixel = (rng() % 4 == 0) ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>(rng() % 16);
+        }
+    }
+
+    std::vector<uint8_t> frame(WIDTH * HEIGHT * 3, 0);
+    std::vector<uint8_t> expected(HEIGHT * row_pitch, 0);
+    std::vector<uint8_t> texels(HEIGHT * row_pitch, 0);
+
+    // Tous les noyaux disponibles doivent produire les mmes texels que l'ancien chemin
+    int best = static_cast<int>(palette_kernel());
+    for (int kernel = 0; kernel <= best; ++kernel) {
+        for (auto& screen : screens) {
+            legacy_path(screen, frame, expected.data(), row_pitch);
+            expand_palette(screen.data(), WIDTH, HEIGHT, texels.data(), row_pitch, static_cast<PaletteKernel>(kernel));
+            for (int y = 0; y < HEIGHT; ++y) {
+                if (std::memcmp(&expected[y * row_pitch], &texels[y * row_pitch], WIDTH * 4) != 0) {
+                    std::printf("Noyau %s : ligne %d diffrente de l'ancien chemin\n", names[kernel], y);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    std::printf("ancien chemin : %8.1f ns/trame\n", measure(screens, [&](const std::vector<uint8_t>& screen) {
+        legacy_path(screen, frame, texels.data(), row_pitch);
+    }));
+    for (int kernel = 0; kernel <= best; ++kernel) {
+        std::printf("%-13s : %8.1f ns/trame\n", names[kernel], measure(screens, [&](const std::vector<uint8_t>& screen) {
+            expand_palette(screen.data(), WIDTH, HEIGHT, texels.data(), row_pitch, static_cast<PaletteKernel>(kernel));
+        }));
+    }
+    return 0;
+}
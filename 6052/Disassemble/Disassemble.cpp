@@ -0,0 +1,166 @@
+// Dsassemble un programme binaire, un programme de dmonstration ou la RAM d'une sauvegarde d'tat
+// g++ -O2 -std=c++17 -I../6052 Disassemble.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/Disassembler.cpp ../6052/OpCodes.cpp ../6052/SaveState.cpp -o disassemble
+#include "Bus.hpp"
+#include "CPU.hpp"
+#include "Disassembler.hpp"
+#include "Programs.hpp"
+#include "SaveState.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define DEFAULT_ORIGIN 0x0600
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+struct Options {
+    std::string input;
+    std::string output = "-";
+    long origin = DEFAULT_ORIGIN;
+    long start = -1;
+    long end = -1;
+};
+
+static void print_usage() {
+    std::cerr << "Usage : disassemble [options] snake|animation|<programme>|<sauvegarde>\n"
+        "  --origin ADDR          adresse de chargement d'un programme ($0600 par dfaut)\n"
+        "  --start ADDR           premire adresse dsassemble (origine par dfaut)\n"
+        "  --end ADDR             dernire adresse dsassemble (fin du programme, $FFFF pour une sauvegarde)\n"
+        "  --output <fichier>|-   destination du listing (sortie standard par dfaut)\n"
+        "Les adresses sont en hexadcimal, avec ou sans $.\n";
+}
+
+static bool parse_address(const std::string& text, long& value) {
+    size_t start = !text.empty() && text[0] == '$' ? 1 : 0;
+    char* end = nullptr;
+    value = std::strtol(text.c_str() + start, &end, 16);
+    return end != text.c_str() + start && *end == '\0' && value >= 0 && value <= 0xFFFF;
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            if (!options.input.empty()) {
+                std::cerr << "Une seule entre attendue : " << arg << std::endl;
+                return false;
+            }
+            options.input = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Valeur manquante pour " << arg << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--output") {
+            options.output = value;
+        }
+        else if (arg == "--origin" || arg == "--start" || arg == "--end") {
+            long& address = arg == "--origin" ? options.origin : arg == "--start" ? options.start : options.end;
+            if (!parse_address(value, address)) {
+                std::cerr << "Adresse invalide : " << value << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Option inconnue : " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.input.empty()) {
+        std::cerr << "Entre manquante" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Mmoire  dsassembler et son adresse de dpart : le programme tel quel, ou les 64 Ko d'une sauvegarde
+static bool load_memory(const Options& options, std::vector<uint8_t>& memory, long& origin) {
+    origin = options.origin;
+    if (options.input == "snake") {
+        memory = SNAKE_PROGRAM;
+        return true;
+    }
+    if (options.input == "animation") {
+        memory = ANIMATION_PROGRAM;
+        return true;
+    }
+
+    std::ifstream file(options.input, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossible d'ouvrir " << options.input << std::endl;
+        return false;
+    }
+    memory.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    if (memory.size() >= 7 && std::memcmp(memory.data(), SAVE_STATE_MAGIC, 7) == 0) {
+        Bus bus;
+        CPU cpu(bus);
+        if (!load_state(cpu, bus, memory)) {
+            return false;
+        }
+        memory.resize(0x10000);
+        bus.read_ram(0, memory.data(), memory.size());
+        origin = 0;
+        return true;
+    }
+    if (memory.empty() || memory.size() > static_cast<size_t>(0x10000 - origin)) {
+        std::cerr << "Taille de programme invalide : " << memory.size() << " octets" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<uint8_t> memory;
+    long origin;
+    if (!load_memory(options, memory, origin)) {
+        return 1;
+    }
+
+    long last = origin + static_cast<long>(memory.size()) - 1;
+    long start = options.start >= 0 ? options.start : (origin == 0 ? DEFAULT_ORIGIN : origin);
+    long end = options.end >= 0 ? options.end : last;
+    if (start < origin || end > last || start > end) {
+        std::fprintf(stderr, "Plage $%04lX-$%04lX hors de la mmoire charge ($%04lX-$%04lX)\n", start, end, origin, last);
+        return 1;
+    }
+
+    FILE* out = options.output == "-" ? stdout : std::fopen(options.output.c_str(), "w");
+    if (!out) {
+        std::cerr << "Impossible d'ouvrir " << options.output << std::endl;
+        return 1;
+    }
+
+    // Une instruction qui dborde de end s'crit octet par octet, comme  la fin de la mmoire
+    std::vector<char> text(OUTPUT_BUFFER_SIZE);
+    size_t pos = static_cast<size_t>(start - origin);
+    size_t stop = static_cast<size_t>(end - origin) + 1;
+    while (pos < stop) {
+        size_t written;
+        pos += disassemble(&memory[pos], stop - pos, static_cast<uint16_t>(origin + pos), text.data(), text.size(), written);
+        std::fwrite(text.data(), 1, written, out);
+    }
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,537 @@
+// Excution sans fentre ni GPU, pour mesurer le dbit et comparer les trames produites
+// g++ -O2 -std=c++17 -I../6052 Headless.cpp ../6052/BatchRunner.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/Color.cpp ../6052/CPU.cpp ../6052/Devices.cpp ../6052/OpCodes.cpp ../6052/Movie.cpp ../6052/Profiler.cpp ../6052/SaveState.cpp ../6052/TraceBuffer.cpp -pthread -o headless
+#include "BatchRunner.hpp"
+#include "Bus.hpp"
+#include "Color.hpp"
+#include "CPU.hpp"
+#include "Devices.hpp"
+#include "Movie.hpp"
+#include "Profiler.hpp"
+#include "Programs.hpp"
+#include "SaveState.hpp"
+#include "TraceBuffer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define DEFAULT_CYCLES_PER_FRAME 60
+#define DEFAULT_FRAMES 600
+#define DEFAULT_TRACE_SIZE (1 << 20)
+
+// Condition facultative d'un point d'arrt : registre (a, x, y, sp ou p) gal  value
+struct BreakpointOption {
+    uint16_t address;
+    std::string reg;
+    uint8_t value;
+};
+
+struct WatchpointOption {
+    uint16_t start;
+    uint16_t end;
+    MemoryAccess access;
+};
+
+enum class FrameFormat {
+    None,
+    Rgba,
+    Y4m,
+};
+
+struct Options {
+    std::string program = "snake";
+    long long frames = -1;
+    long long cycles = -1;
+    int cycles_per_frame = DEFAULT_CYCLES_PER_FRAME;
+    uint32_t seed = 1;
+    FrameFormat format = FrameFormat::None;
+    std::string output = "-";
+    std::string profile;
+    std::string profile_json;
+    std::string trace;
+    size_t trace_size = DEFAULT_TRACE_SIZE;
+    std::string replay;
+    std::string load_state;
+    std::string save_state;
+    std::vector<BreakpointOption> breakpoints;
+    std::vector<WatchpointOption> watchpoints;
+    size_t sessions = 0;
+    unsigned threads = 0;
+};
+
+// Profileur, trace et film rejou partagent HOOK_EXECUTE : un seul hook les appelle tous
+struct Instruments {
+    static constexpr uint8_t hook_mask = HOOK_EXECUTE;
+
+    Profiler* profiler = nullptr;
+    TraceBuffer* trace = nullptr;
+    InputPlayer* player = nullptr;
+
+    void on_execute(const CPU& cpu, const DecodedInstruction& instruction) {
+        if (player) {
+            player->on_execute(cpu, instruction);
+        }
+        if (profiler) {
+            profiler->on_execute(cpu, instruction);
+        }
+        if (trace) {
+            trace->on_execute(cpu, instruction);
+        }
+    }
+};
+
+static void print_usage() {
+    std::cerr << "Usage : headless [options]\n"
+        "  --program snake|animation|<fichier>  programme charg en $0600 (snake par dfaut)\n"
+        "  --frames N                           nombre de trames  excuter (" << DEFAULT_FRAMES << " par dfaut)\n"
+        "  --cycles N                           nombre de cycles  excuter,  la place de --frames\n"
+        "  --cycles-per-frame N                 cycles par trame (" << DEFAULT_CYCLES_PER_FRAME << " par dfaut)\n"
+        "  --seed N                             graine du registre alatoire $FE\n"
+        "  --format rgba|y4m                    crit chaque trame, en RGBA 32x32 brut ou en Y4M\n"
+        "  --output <fichier>|-                 destination des trames (sortie standard par dfaut)\n"
+        "  --profile <fichier>                  profil par adresse au format collapsed stack (flamegraph)\n"
+        "  --profile-json <fichier>             rsum du profil par opcode et par adresse en JSON\n"
+        "  --trace <fichier>                    trace binaire des dernires instructions (voir TraceDecode)\n"
+        "  --trace-size N                       instructions conserves dans la trace (" << DEFAULT_TRACE_SIZE << " par dfaut)\n"
+        "  --replay <film>                      rejoue la graine et les touches enregistres par 6052 --record\n"
+        "  --load-state <fichier>               reprend  partir d'une sauvegarde d'tat\n"
+        "  --save-state <fichier>               sauvegarde l'tat (compress) en fin d'excution\n"
+        "  --break ADDR[:REG=VAL]               s'arrte avant l'instruction en ADDR (hexadcimal), si REG (a, x, y, sp, p) vaut VAL\n"
+        "  --watch ADDR[-FIN][:r|w|rw]          s'arrte aprs un accs du CPU  ces octets (criture par dfaut)\n"
+        "  --sessions N                         N sessions indpendantes, graines seed  seed + N - 1, sans sortie de trames\n"
+        "  --threads N                          threads des sessions (un par processeur logique par dfaut)\n";
+}
+
+// Hexadcimal, avec ou sans $ ; false si la valeur ne tient pas sur 16 bits ou ne va pas jusqu' stop
+static bool parse_hex(const std::string& text, char stop, uint16_t& value) {
+    size_t start = !text.empty() && text[0] == '$' ? 1 : 0;
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text.c_str() + start, &end, 16);
+    if (end == text.c_str() + start || *end != stop || parsed > 0xFFFF) {
+        return false;
+    }
+    value = static_cast<uint16_t>(parsed);
+    return true;
+}
+
+static bool parse_breakpoint(const std::string& value, BreakpointOption& breakpoint) {
+    size_t colon = value.find(':');
+    if (!parse_hex(value.substr(0, colon), '\0', breakpoint.address)) {
+        return false;
+    }
+    if (colon == std::string::npos) {
+        return true;
+    }
+
+    size_t equal = value.find('=', colon);
+    if (equal == std::string::npos) {
+        return false;
+    }
+    breakpoint.reg = value.substr(colon + 1, equal - colon - 1);
+    uint16_t register_value;
+    if (!parse_hex(value.substr(equal + 1), '\0', register_value) || register_value > 0xFF) {
+        return false;
+    }
+    breakpoint.value = static_cast<uint8_t>(register_value);
+    return breakpoint.reg == "a" || breakpoint.reg == "x" || breakpoint.reg == "y" || breakpoint.reg == "sp" || breakpoint.reg == "p";
+}
+
+static bool parse_watchpoint(const std::string& value, WatchpointOption& watchpoint) {
+    size_t colon = value.find(':');
+    std::string range = value.substr(0, colon);
+    size_t dash = range.find('-');
+    if (!parse_hex(range.substr(0, dash), '\0', watchpoint.start)) {
+        return false;
+    }
+    watchpoint.end = watchpoint.start;
+    if (dash != std::string::npos && (!parse_hex(range.substr(dash + 1), '\0', watchpoint.end) || watchpoint.end < watchpoint.start)) {
+        return false;
+    }
+
+    std::string kind = colon == std::string::npos ? "w" : value.substr(colon + 1);
+    if (kind == "r") {
+        watchpoint.access = MemoryAccess::Read;
+    }
+    else if (kind == "w") {
+        watchpoint.access = MemoryAccess::Write;
+    }
+    else if (kind == "rw") {
+        watchpoint.access = MemoryAccess::ReadWrite;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+static uint8_t register_value(const CPU& cpu, const std::string& reg) {
+    if (reg == "a") {
+        return cpu.register_a;
+    }
+    if (reg == "x") {
+        return cpu.register_x;
+    }
+    if (reg == "y") {
+        return cpu.register_y;
+    }
+    if (reg == "sp") {
+        return cpu.stack_pointer;
+    }
+    return cpu.get_status();
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Valeur manquante pour " << arg << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--program") {
+            options.program = value;
+        }
+        else if (arg == "--frames") {
+            options.frames = std::atoll(value.c_str());
+        }
+        else if (arg == "--cycles") {
+            options.cycles = std::atoll(value.c_str());
+        }
+        else if (arg == "--cycles-per-frame") {
+            options.cycles_per_frame = std::atoi(value.c_str());
+        }
+        else if (arg == "--seed") {
+            options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--format") {
+            if (value == "rgba") {
+                options.format = FrameFormat::Rgba;
+            }
+            else if (value == "y4m") {
+                options.format = FrameFormat::Y4m;
+            }
+            else {
+                std::cerr << "Format inconnu : " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--output") {
+            options.output = value;
+        }
+        else if (arg == "--profile") {
+            options.profile = value;
+        }
+        else if (arg == "--profile-json") {
+            options.profile_json = value;
+        }
+        else if (arg == "--trace") {
+            options.trace = value;
+        }
+        else if (arg == "--trace-size") {
+            options.trace_size = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--replay") {
+            options.replay = value;
+        }
+        else if (arg == "--load-state") {
+            options.load_state = value;
+        }
+        else if (arg == "--save-state") {
+            options.save_state = value;
+        }
+        else if (arg == "--sessions") {
+            options.sessions = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--threads") {
+            options.threads = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--break") {
+            BreakpointOption breakpoint;
+            if (!parse_breakpoint(value, breakpoint)) {
+                std::cerr << "Point d'arrt invalide : " << value << std::endl;
+                return false;
+            }
+            options.breakpoints.push_back(breakpoint);
+        }
+        else if (arg == "--watch") {
+            WatchpointOption watchpoint;
+            if (!parse_watchpoint(value, watchpoint)) {
+                std::cerr << "Point de surveillance invalide : " << value << std::endl;
+                return false;
+            }
+            options.watchpoints.push_back(watchpoint);
+        }
+        else {
+            std::cerr << "Option inconnue : " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.cycles_per_frame <= 0) {
+        std::cerr << "--cycles-per-frame doit tre positif" << std::endl;
+        return false;
+    }
+    // Un film rejou s'arrte par dfaut l o l'enregistrement s'est arrt
+    if (options.frames < 0 && options.cycles < 0 && options.replay.empty()) {
+        options.frames = DEFAULT_FRAMES;
+    }
+    return true;
+}
+
+static bool load_program(const std::string& name, std::vector<uint8_t>& program) {
+    if (name == "snake") {
+        program = SNAKE_PROGRAM;
+        return true;
+    }
+    if (name == "animation") {
+        program = ANIMATION_PROGRAM;
+        return true;
+    }
+
+    std::ifstream file(name, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossible d'ouvrir le programme " << name << std::endl;
+        return false;
+    }
+    program.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (program.empty() || program.size() > 0x10000 - 0x0600) {
+        std::cerr << "Taille de programme invalide : " << program.size() << " octets" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Chaque session rejoue les touches du film ventuel avec sa propre graine, jusqu'au BRK ou au budget
+static int run_sessions(const Options& options, const std::vector<uint8_t>& program, const Movie& movie) {
+    uint64_t max_cycles = options.cycles >= 0 ? static_cast<uint64_t>(options.cycles)
+        : static_cast<uint64_t>(options.frames) * static_cast<uint64_t>(options.cycles_per_frame);
+    BatchRunner batch(program, options.threads);
+    Movie inputs = movie;
+    for (size_t i = 0; i < options.sessions; ++i) {
+        inputs.seed = options.seed + static_cast<uint32_t>(i);
+        batch.add(inputs, max_cycles);
+    }
+    batch.run();
+
+    size_t halted = 0;
+    size_t illegal = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        halted += batch.result(i).stop == StopReason::Halted ? 1 : 0;
+        illegal += batch.result(i).stop == StopReason::IllegalOpcode ? 1 : 0;
+    }
+    std::fprintf(stderr, "%zu sessions (%zu BRK, %zu opcodes non documents), %llu cycles en %.3f s : %.2f MHz cumuls\n",
+        batch.size(), halted, illegal, static_cast<unsigned long long>(batch.total_cycles()), batch.elapsed_seconds(), batch.emulated_mhz());
+    return 0;
+}
+
+// BT.601, plage vido limite, sans sous-chantillonnage de la chrominance (C444)
+static void write_y4m_frame(FILE* out, const std::vector<uint8_t>& rgba) {
+    std::vector<uint8_t> planes(FRAMEBUFFER_SIZE * 3);
+    for (int i = 0; i < FRAMEBUFFER_SIZE; ++i) {
+        int r = rgba[i * 4];
+        int g = rgba[i * 4 + 1];
+        int b = rgba[i * 4 + 2];
+        planes[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        planes[FRAMEBUFFER_SIZE + i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        planes[FRAMEBUFFER_SIZE * 2 + i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    std::fputs("FRAME\n", out);
+    std::fwrite(planes.data(), 1, planes.size(), out);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<uint8_t> program;
+    if (!load_program(options.program, program)) {
+        return 1;
+    }
+
+    Movie movie;
+    if (!options.replay.empty()) {
+        if (!movie.load(options.replay)) {
+            return 1;
+        }
+        if (movie.program_hash != program_hash(program)) {
+            std::cerr << "Attention : le film a t enregistr avec un autre programme" << std::endl;
+        }
+        options.seed = movie.seed;
+        if (options.frames < 0 && options.cycles < 0) {
+            options.cycles = static_cast<long long>(movie.end_cycle);
+        }
+    }
+
+    if (options.sessions > 0) {
+        return run_sessions(options, program, movie);
+    }
+
+    FILE* out = nullptr;
+    if (options.format != FrameFormat::None) {
+        out = options.output == "-" ? stdout : std::fopen(options.output.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Impossible d'ouvrir " << options.output << std::endl;
+            return 1;
+        }
+        if (options.format == FrameFormat::Y4m) {
+            std::fprintf(out, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 C444\n", FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        }
+    }
+
+    Bus bus;
+    CPU cpu(bus);
+    RandomDevice random_device(options.seed);
+    KeyboardLatch keyboard;
+    Framebuffer framebuffer;
+    random_device.attach(bus);
+    keyboard.attach(bus);
+    framebuffer.attach(bus);
+
+    cpu.load(program);
+    cpu.reset();
+    if (!options.load_state.empty()) {
+        if (!load_state_file(options.load_state, cpu, bus)) {
+            return 1;
+        }
+        framebuffer.invalidate();
+    }
+
+    // Profileur et trace dsactivent le saut des boucles d'attente : les cycles sont les mmes, le dbit non
+    std::unique_ptr<Profiler> profiler;
+    std::unique_ptr<TraceBuffer> trace;
+    std::unique_ptr<InputPlayer> player;
+    Instruments instruments;
+    if (!options.profile.empty() || !options.profile_json.empty()) {
+        profiler = std::make_unique<Profiler>();
+        instruments.profiler = profiler.get();
+    }
+    if (!options.trace.empty()) {
+        trace = std::make_unique<TraceBuffer>(options.trace_size);
+        instruments.trace = trace.get();
+    }
+    if (!options.replay.empty()) {
+        player = std::make_unique<InputPlayer>(movie, keyboard);
+        instruments.player = player.get();
+    }
+
+    for (const BreakpointOption& breakpoint : options.breakpoints) {
+        if (breakpoint.reg.empty()) {
+            cpu.add_breakpoint(breakpoint.address);
+        }
+        else {
+            cpu.add_breakpoint(breakpoint.address, [breakpoint](const CPU& cpu) { return register_value(cpu, breakpoint.reg) == breakpoint.value; });
+        }
+    }
+    for (const WatchpointOption& watchpoint : options.watchpoints) {
+        cpu.add_watchpoint(watchpoint.start, watchpoint.end, watchpoint.access);
+    }
+
+    std::vector<uint8_t> screen_state(FRAMEBUFFER_SIZE * 4, 0);
+    long long frames = 0;
+    long long cycles = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (cpu.is_cpu_running()) {
+        if (options.frames >= 0 && frames >= options.frames) {
+            break;
+        }
+        if (options.cycles >= 0 && cycles >= options.cycles) {
+            break;
+        }
+
+        if (profiler || trace) {
+            cycles += cpu.run_with_callback(instruments, options.cycles_per_frame);
+        }
+        else if (player) {
+            cycles += player->run(cpu, options.cycles_per_frame);
+        }
+        else {
+            cycles += cpu.run(options.cycles_per_frame);
+        }
+        frames++;
+
+        if (out) {
+            uint32_t dirty_rows = framebuffer.take_dirty_rows();
+            for (int y = 0; y < FRAMEBUFFER_HEIGHT; ++y) {
+                if (dirty_rows & (1u << y)) {
+                    size_t offset = static_cast<size_t>(y) * FRAMEBUFFER_WIDTH;
+                    expand_palette(framebuffer.row(y), FRAMEBUFFER_WIDTH, 1, &screen_state[offset * 4], FRAMEBUFFER_WIDTH * 4);
+                }
+            }
+
+            if (options.format == FrameFormat::Y4m) {
+                write_y4m_frame(out, screen_state);
+            }
+            else {
+                std::fwrite(screen_state.data(), 1, screen_state.size(), out);
+            }
+        }
+
+        const StopInfo& stop = cpu.stop_info();
+        if (stop.reason == StopReason::IllegalOpcode) {
+            std::fprintf(stderr, "Opcode non document $%02X en $%04X au cycle %lld\n", bus.peek(stop.address), stop.address, cycles);
+            break;
+        }
+        if (stop.reason == StopReason::Breakpoint || stop.reason == StopReason::Watchpoint) {
+            if (stop.reason == StopReason::Breakpoint) {
+                std::fprintf(stderr, "Point d'arrt en $%04X", stop.address);
+            }
+            else {
+                std::fprintf(stderr, "%s de $%04X", stop.access == MemoryAccess::Write ? "criture" : "Lecture", stop.address);
+            }
+            std::fprintf(stderr, " au cycle %lld : PC:%04X A:%02X X:%02X Y:%02X P:%02X SP:%02X\n", cycles,
+                cpu.program_counter, cpu.register_a, cpu.register_x, cpu.register_y, cpu.get_status(), cpu.stack_pointer);
+            break;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if (out && out != stdout) {
+        std::fclose(out);
+    }
+    else if (out) {
+        std::fflush(out);
+    }
+
+    if (profiler && !options.profile.empty()) {
+        std::ofstream file(options.profile);
+        if (!file) {
+            std::cerr << "Impossible d'ouvrir " << options.profile << std::endl;
+        }
+        profiler->write_collapsed(file);
+    }
+    if (profiler && !options.profile_json.empty()) {
+        std::ofstream file(options.profile_json);
+        if (!file) {
+            std::cerr << "Impossible d'ouvrir " << options.profile_json << std::endl;
+        }
+        profiler->write_json(file);
+    }
+
+    if (trace) {
+        trace->save(options.trace);
+    }
+    if (!options.save_state.empty()) {
+        save_state_file(options.save_state, cpu, bus, true);
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::fprintf(stderr, "%lld trames, %lld cycles (%llu sauts) en %.3f s : %.2f MHz, %.0f trames/s%s\n",
+        frames, cycles, static_cast<unsigned long long>(cpu.skipped_cycles()), seconds,
+        seconds > 0 ? cycles / seconds / 1e6 : 0.0, seconds > 0 ? frames / seconds : 0.0,
+        cpu.is_cpu_running() ? "" : cpu.stop_info().reason == StopReason::IllegalOpcode ? " (opcode non document)" : " (BRK)");
+    return 0;
+}
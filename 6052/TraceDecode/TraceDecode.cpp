@@ -0,0 +1,95 @@
+// Convertit une trace binaire (TraceBuffer::save, headless --trace) en journal texte au format nestest
+// g++ -O2 -std=c++17 -I../6052 TraceDecode.cpp ../6052/BlockCache.cpp ../6052/Bus.cpp ../6052/CPU.cpp ../6052/Disassembler.cpp ../6052/OpCodes.cpp -o tracedecode
+#include "Disassembler.hpp"
+#include "TraceBuffer.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define RECORDS_PER_READ 65536
+// Le texte de l'instruction est complt  32 colonnes, puis les registres et jusqu' 20 chiffres de cycle
+#define TEXT_COLUMNS 32
+#define LINE_MAX (16 + TEXT_COLUMNS + 30 + 20 + 1)
+
+// C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD CYC:7
+static char* format_record(char* out, const TraceRecord& record, uint64_t cycle) {
+    uint8_t bytes[3] = { record.opcode, record.operand_lo, record.operand_hi };
+    char* text = out + 16;
+    out = format_line(out, record.pc, bytes);
+    while (out < text + TEXT_COLUMNS) {
+        *out++ = ' ';
+    }
+
+    static const char* const LABELS[] = { "A:", " X:", " Y:", " P:", " SP:" };
+    const uint8_t registers[] = { record.register_a, record.register_x, record.register_y, record.status, record.stack_pointer };
+    for (size_t i = 0; i < 5; ++i) {
+        for (const char* label = LABELS[i]; *label; ++label) {
+            *out++ = *label;
+        }
+        out = format_hex8(out, registers[i]);
+    }
+    std::memcpy(out, " CYC:", 5);
+    out = std::to_chars(out + 5, out + 25, cycle).ptr;
+    *out++ = '\n';
+    return out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage : tracedecode <trace> [journal]" << std::endl;
+        return 1;
+    }
+
+    FILE* in = std::fopen(argv[1], "rb");
+    if (!in) {
+        std::cerr << "Impossible d'ouvrir " << argv[1] << std::endl;
+        return 1;
+    }
+
+    TraceFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, in) != 1 || std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+        || header.record_size != sizeof(TraceRecord)) {
+        std::cerr << argv[1] << " n'est pas une trace valide" << std::endl;
+        std::fclose(in);
+        return 1;
+    }
+
+    FILE* out = argc == 3 ? std::fopen(argv[2], "w") : stdout;
+    if (!out) {
+        std::cerr << "Impossible d'ouvrir " << argv[2] << std::endl;
+        std::fclose(in);
+        return 1;
+    }
+
+    // Les enregistrements ne gardent que 32 bits du compteur : on les recale sur le prcdent
+    std::vector<TraceRecord> records(RECORDS_PER_READ);
+    std::vector<char> text(static_cast<size_t>(RECORDS_PER_READ) * LINE_MAX);
+    uint64_t cycle = header.first_cycle;
+    uint64_t remaining = header.record_count;
+    while (remaining > 0) {
+        size_t wanted = remaining < RECORDS_PER_READ ? static_cast<size_t>(remaining) : RECORDS_PER_READ;
+        size_t count = std::fread(records.data(), sizeof(TraceRecord), wanted, in);
+        if (count == 0) {
+            std::cerr << "Trace tronque : " << remaining << " enregistrements manquants" << std::endl;
+            break;
+        }
+        char* cursor = text.data();
+        for (size_t i = 0; i < count; ++i) {
+            cycle += static_cast<uint32_t>(records[i].cycle - static_cast<uint32_t>(cycle));
+            cursor = format_record(cursor, records[i], cycle);
+        }
+        std::fwrite(text.data(), 1, cursor - text.data(), out);
+        remaining -= count;
+    }
+
+    std::fclose(in);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return remaining == 0 ? 0 : 1;
+}